@@ -5,10 +5,14 @@ layout(location = 0) in vec3 vertex_position;
 uniform mat4 projection;
 uniform mat4 view;
 
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+
 out vec3 frag_position;
 
 void main()
 {
-    frag_position = vertex_position;
-    gl_Position = projection * view * vec4(vertex_position, 1.0);
+    vec3 position = position_offset + vertex_position * position_scale;
+    frag_position = position;
+    gl_Position = projection * view * vec4(position, 1.0);
 }
@@ -5,17 +5,40 @@ layout(location = 1) in vec2 vertex_texcoord;
 layout(location = 2) in vec3 vertex_normal;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat4 mvp;
+uniform mat3 normal_matrix;
+
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+uniform vec2 texcoord_offset;
+uniform vec2 texcoord_scale;
+uniform bool octahedral_normals;
 
 out vec3 frag_position;
 out vec2 frag_texcoord;
 out vec3 frag_normal;
 
+vec3 decode_normal(vec3 normal)
+{
+    if (!octahedral_normals)
+        return normal;
+
+    vec2 e = normal.xy * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
-    gl_Position = projection * view * model * vec4(vertex_position, 1.0);
-    frag_position = vec3(model * vec4(vertex_position, 1.0));
-    frag_texcoord = vertex_texcoord;
-    frag_normal = mat3(transpose(inverse(model))) * vertex_normal;
+    vec3 position = position_offset + vertex_position * position_scale;
+    vec2 texcoord = texcoord_offset + vertex_texcoord * texcoord_scale;
+    vec3 normal = decode_normal(vertex_normal);
+
+    gl_Position = mvp * vec4(position, 1.0);
+    frag_position = vec3(model * vec4(position, 1.0));
+    frag_texcoord = texcoord;
+    frag_normal = normal_matrix * normal;
 }
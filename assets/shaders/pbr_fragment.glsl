@@ -12,11 +12,13 @@ struct Light {
 in vec3 frag_position;
 in vec2 frag_texcoord;
 in vec3 frag_normal;
+in vec4 frag_tangent;
 
 uniform sampler2D albedo_texture;
 uniform sampler2D normal_texture;
 uniform sampler2D metalness_texture;
 uniform sampler2D roughness_texture;
+uniform int packed_metal_roughness; // glTF, metalness in blue and roughness in green
 uniform samplerCube irradiance_map;
 uniform samplerCube prefilter_map;
 uniform sampler2D brdf_lut_map;
@@ -78,8 +80,17 @@ void main()
     vec3 normal = texture(normal_texture, frag_texcoord).rgb;
     float metalness = texture(metalness_texture, frag_texcoord).r;
     float roughness = texture(roughness_texture, frag_texcoord).r;
+    if (packed_metal_roughness != 0) {
+        vec4 metal_roughness = texture(metalness_texture, frag_texcoord);
+        metalness = metal_roughness.b;
+        roughness = metal_roughness.g;
+    }
 
-    vec3 N = normalize(frag_normal);
+    // MikkTSpace wants the interpolated frame as is, the bitangent rebuilt per pixel and
+    // the result normalised once
+    vec3 bitangent = frag_tangent.w * cross(frag_normal, frag_tangent.xyz);
+    normal = normal * 2.0 - 1.0;
+    vec3 N = normalize(normal.x * frag_tangent.xyz + normal.y * bitangent + normal.z * frag_normal);
     vec3 V = normalize(camera_position - frag_position);
     vec3 R = reflect(-V, N);
 
@@ -1,21 +1,71 @@
 #version 330 core
 
-layout(location = 0) in vec3 vertex_position;
+layout(location = 0) in vec4 vertex_position;
 layout(location = 1) in vec2 vertex_texcoord;
 layout(location = 2) in vec3 vertex_normal;
+layout(location = 3) in vec4 vertex_tangent;
 
+// constant per draw, so they're worked out on the CPU
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat4 mvp;
+uniform mat3 normal_matrix;
+
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+uniform vec2 texcoord_offset;
+uniform vec2 texcoord_scale;
+uniform bool octahedral_normals;
 
 out vec3 frag_position;
 out vec2 frag_texcoord;
 out vec3 frag_normal;
+out vec4 frag_tangent;
+
+vec3 decode_normal(vec3 normal)
+{
+    if (!octahedral_normals)
+        return normal;
+
+    vec2 e = normal.xy * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+// packed tangents are an angle around the normal in position w, top bit is the sign
+vec4 decode_tangent(vec3 normal, float packed)
+{
+    if (!octahedral_normals)
+        return vertex_tangent;
+
+    float bits = floor(packed * 65535.0 + 0.5);
+    float turns = mod(bits, 32768.0) / 32768.0;
+    float angle = turns * 6.28318530718;
+
+    // the hemisphere comes from the exact octahedral code, like the CPU side picks it
+    vec2 code = floor(vertex_normal.xy * 65535.0 + 0.5);
+    float s = abs(2.0 * code.x - 65535.0) + abs(2.0 * code.y - 65535.0) > 65535.0 ? -1.0 : 1.0;
+
+    float a = -1.0 / (s + normal.z);
+    float b = normal.x * normal.y * a;
+    vec3 b1 = vec3(1.0 + s * normal.x * normal.x * a, s * b, -s * normal.x);
+    vec3 b2 = vec3(b, s + normal.y * normal.y * a, -normal.y);
+
+    return vec4(cos(angle) * b1 + sin(angle) * b2, bits >= 32768.0 ? -1.0 : 1.0);
+}
 
 void main()
 {
-    frag_position = vec3(model * vec4(vertex_position, 1.0));
-    frag_texcoord = vertex_texcoord;
-    frag_normal = mat3(transpose(inverse(model))) * vertex_normal;
-    gl_Position = projection * view * model * vec4(vertex_position, 1.0);
+    vec3 position = position_offset + vertex_position.xyz * position_scale;
+    vec2 texcoord = texcoord_offset + vertex_texcoord * texcoord_scale;
+    vec3 normal = decode_normal(vertex_normal);
+    vec4 tangent = decode_tangent(normal, vertex_position.w);
+
+    frag_position = vec3(model * vec4(position, 1.0));
+    frag_texcoord = texcoord;
+    frag_normal = normal_matrix * normal;
+    frag_tangent = vec4(mat3(model) * tangent.xyz, tangent.w);
+    gl_Position = mvp * vec4(position, 1.0);
 }
@@ -5,11 +5,15 @@ layout(location = 0) in vec3 vertex_position;
 uniform mat4 view;
 uniform mat4 projection;
 
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+
 out vec3 frag_texcoord;
 
 void main()
 {
-	vec4 position = projection * view * vec4(vertex_position, 1.0);
+	vec3 local_position = position_offset + vertex_position * position_scale;
+	vec4 position = projection * view * vec4(local_position, 1.0);
 	gl_Position = position.xyww;
-	frag_texcoord = vertex_position;
+	frag_texcoord = local_position;
 }
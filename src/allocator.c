@@ -0,0 +1,100 @@
+#include "allocator.h"
+
+// Sits in front of every block, 16 bytes so what follows keeps malloc's alignment.
+typedef struct AllocationHeader {
+    usize size;
+    u32 tag;
+    b32 counted;
+} AllocationHeader;
+
+static const char *memory_tag_names[MEMORY_TAG_COUNT] = {
+    "file", "image", "mesh", "mesh build", "gl buffer", "gl texture"
+};
+
+void track_memory_growth(MemoryTag tag, s64 bytes, s32 allocations)
+{
+    MemoryStats *stats = global_memory_stats;
+    if (!stats) return;
+
+    MemoryTagStats *tag_stats = &stats->tags[tag];
+    s64 current = InterlockedExchangeAdd64((LONG64 volatile *)&tag_stats->current, bytes) + bytes;
+    if (allocations) {
+        InterlockedExchangeAdd64((LONG64 volatile *)&tag_stats->count, allocations);
+        if (allocations > 0) InterlockedExchangeAdd64((LONG64 volatile *)&tag_stats->total, allocations);
+    }
+
+    // another thread can raise the peak between the read and the exchange, so try again
+    s64 peak = tag_stats->peak;
+    while (current > peak) {
+        s64 original = InterlockedCompareExchange64((LONG64 volatile *)&tag_stats->peak, current, peak);
+        if (original == peak) break;
+        peak = original;
+    }
+}
+
+void track_memory(MemoryTag tag, s64 bytes)
+{
+    track_memory_growth(tag, bytes, (bytes > 0) ? 1 : (bytes < 0) ? -1 : 0);
+}
+
+static void *finish_allocation(AllocationHeader *header, MemoryTag tag, usize size)
+{
+    if (!header) return NULL;
+
+    header->size = size;
+    header->tag = tag;
+    header->counted = (global_memory_stats != NULL);
+    if (header->counted) track_memory(tag, (s64)size);
+
+    return header + 1;
+}
+
+void *allocate(MemoryTag tag, usize size)
+{
+    return finish_allocation((AllocationHeader *)malloc(sizeof(AllocationHeader) + size), tag, size);
+}
+
+void *allocate_cleared(MemoryTag tag, usize size)
+{
+    return finish_allocation((AllocationHeader *)calloc(1, sizeof(AllocationHeader) + size), tag, size);
+}
+
+void *reallocate(MemoryTag tag, void *memory, usize size)
+{
+    if (!memory) return allocate(tag, size);
+
+    AllocationHeader *header = (AllocationHeader *)memory - 1;
+    MemoryTag block_tag = (MemoryTag)header->tag;
+    if (header->counted) track_memory(block_tag, -(s64)header->size);
+
+    AllocationHeader *result = (AllocationHeader *)realloc(header, sizeof(AllocationHeader) + size);
+    if (!result) {
+        // the old block is still there
+        if (header->counted) track_memory(block_tag, (s64)header->size);
+        return NULL;
+    }
+
+    return finish_allocation(result, block_tag, size);
+}
+
+void deallocate(void *memory)
+{
+    if (!memory) return;
+
+    AllocationHeader *header = (AllocationHeader *)memory - 1;
+    if (header->counted) track_memory((MemoryTag)header->tag, -(s64)header->size);
+    free(header);
+}
+
+void print_memory_stats(void)
+{
+    MemoryStats *stats = global_memory_stats;
+    if (!stats) return;
+
+    printf("memory          current KB     peak KB     live    total\n");
+    for (u32 i = 0; i < MEMORY_TAG_COUNT; i++) {
+        MemoryTagStats *tag_stats = &stats->tags[i];
+        printf("%-12s %12lld %11lld %8lld %8lld\n", memory_tag_names[i], (long long)(tag_stats->current / 1024),
+            (long long)(tag_stats->peak / 1024), (long long)tag_stats->count, (long long)tag_stats->total);
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+// Heap allocations go through these instead of malloc, tagged with the subsystem they're
+// for so the memory stats can say where memory goes. GL buffers and textures aren't heap
+// memory but are tracked alongside with track_memory.
+typedef enum MemoryTag {
+    MEMORY_TAG_FILE,       // read_file
+    MEMORY_TAG_IMAGE,      // stb_image while it decodes
+    MEMORY_TAG_MESH,       // draw data and upload staging
+    MEMORY_TAG_MESH_BUILD, // scratch of the loaders and mesh processing passes
+    MEMORY_TAG_GL_BUFFER,
+    MEMORY_TAG_GL_TEXTURE,
+    MEMORY_TAG_COUNT
+} MemoryTag;
+
+// Updated from any thread, so only with interlocked operations.
+typedef struct MemoryTagStats {
+    s64 volatile current; // bytes
+    s64 volatile peak;
+    s64 volatile count;   // live allocations
+    s64 volatile total;   // allocations ever made, a reallocate counts again
+} MemoryTagStats;
+
+typedef struct MemoryStats {
+    MemoryTagStats tags[MEMORY_TAG_COUNT];
+} MemoryStats;
+
+// Where the stats go, NULL until the game points it at its own. Allocations made while
+// it's NULL aren't counted when they're freed either.
+static MemoryStats *global_memory_stats;
+
+void *allocate(MemoryTag tag, usize size);
+void *allocate_cleared(MemoryTag tag, usize size);
+// Like realloc, memory can be NULL. The block keeps the tag it was allocated with.
+void *reallocate(MemoryTag tag, void *memory, usize size);
+void deallocate(void *memory);
+
+// For memory the allocator doesn't hand out, bytes is negative when it's given back.
+void track_memory(MemoryTag tag, s64 bytes);
+// For memory that grows in place, like a scratch arena committing pages. The live count
+// changes by allocations, so one reservation counts once however often it grows.
+void track_memory_growth(MemoryTag tag, s64 bytes, s32 allocations);
+void print_memory_stats(void);
+
+#endif /* ALLOCATOR_H */
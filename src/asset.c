@@ -0,0 +1,369 @@
+#include "asset.h"
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+
+void init_asset_registry(AssetRegistry *registry, MemoryArena *arena)
+{
+    assert((ASSET_TABLE_SIZE & (ASSET_TABLE_SIZE - 1)) == 0);
+    assert(ASSET_TABLE_SIZE >= 2 * (MAX_TEXTURES + MAX_SHADERS + MAX_MESHES));
+
+    memset(registry, 0, sizeof(AssetRegistry));
+    registry->arena = arena;
+
+    init_pool(&registry->textures, arena, MAX_TEXTURES, sizeof(Texture));
+    init_pool(&registry->shaders, arena, MAX_SHADERS, sizeof(Shader));
+    init_pool(&registry->meshes, arena, MAX_MESHES, sizeof(Mesh));
+    init_pool(&registry->materials, arena, MAX_MATERIALS, sizeof(Material));
+
+    init_mesh_streamer(&registry->streamer, registry);
+}
+
+// FNV-1a over the full path, lower case with forward slashes, so "../assets/A.tga" and
+// "..\assets\a.tga" from another working directory land on the same key. Returns false
+// when the full path doesn't fit in MAX_PATH, the file can't be keyed.
+static b32 hash_path(u64 *hash, const char *file_name)
+{
+    char full_path[MAX_PATH];
+    DWORD length = GetFullPathNameA(file_name, sizeof(full_path), full_path, NULL);
+    if (length == 0 || length >= sizeof(full_path)) {
+        printf("%s: path is too long, using the missing asset\n", file_name);
+        return false;
+    }
+
+    for (DWORD i = 0; i < length; i++) {
+        char c = full_path[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c == '\\') c = '/';
+
+        *hash ^= (u8)c;
+        *hash *= FNV_PRIME;
+    }
+
+    return true;
+}
+
+// names of generated assets hash as they are, behind a prefix no path can start with
+static u64 hash_name(const char *name)
+{
+    u64 hash = FNV_OFFSET_BASIS;
+    for (const char *at = "<generated>"; *at; at++) {
+        hash ^= (u8)*at;
+        hash *= FNV_PRIME;
+    }
+    for (const char *at = name; *at; at++) {
+        hash ^= (u8)*at;
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+// Returns the slot holding key, or the empty slot it should go in.
+static Asset *find_asset(AssetRegistry *registry, u64 key)
+{
+    u32 slot = (u32)key & (ASSET_TABLE_SIZE - 1);
+    while (registry->slots[slot].key && registry->slots[slot].key != key)
+        slot = (slot + 1) & (ASSET_TABLE_SIZE - 1);
+
+    return &registry->slots[slot];
+}
+
+static void add_asset(AssetRegistry *registry, Asset *asset, u64 key, AssetType type, u32 handle)
+{
+    assert(registry->count < ASSET_TABLE_SIZE / 2);
+    registry->count++;
+
+    asset->key = key;
+    asset->type = type;
+    asset->handle = handle;
+}
+
+// Drops whichever slot holds handle, if any. The entries after it in the probe run shift
+// back over the hole so find_asset never stops short of them.
+static void forget_asset(AssetRegistry *registry, AssetType type, u32 handle)
+{
+    u32 hole = 0;
+    while (hole < ASSET_TABLE_SIZE && !(registry->slots[hole].key && registry->slots[hole].type == type && registry->slots[hole].handle == handle))
+        hole++;
+    if (hole == ASSET_TABLE_SIZE) return;
+
+    for (u32 slot = (hole + 1) & (ASSET_TABLE_SIZE - 1); registry->slots[slot].key; slot = (slot + 1) & (ASSET_TABLE_SIZE - 1)) {
+        // an entry can move back unless its home slot is between the hole and where it is now
+        u32 home = (u32)registry->slots[slot].key & (ASSET_TABLE_SIZE - 1);
+        if (((slot - home) & (ASSET_TABLE_SIZE - 1)) >= ((slot - hole) & (ASSET_TABLE_SIZE - 1))) {
+            registry->slots[hole] = registry->slots[slot];
+            hole = slot;
+        }
+    }
+
+    memset(&registry->slots[hole], 0, sizeof(Asset));
+    registry->count--;
+}
+
+// 0 is the empty slot, the odds of a path hashing to it are negligible but not zero
+inline u64 make_asset_key(u64 hash)
+{
+    return hash ? hash : 1;
+}
+
+TextureHandle add_texture(AssetRegistry *registry, Texture texture)
+{
+    TextureHandle handle = { pool_alloc(&registry->textures) };
+    *lookup_texture(registry, handle) = texture;
+    track_memory(MEMORY_TAG_GL_TEXTURE, texture.size);
+
+    return handle;
+}
+
+static ShaderHandle add_shader(AssetRegistry *registry, Shader shader)
+{
+    ShaderHandle handle = { pool_alloc(&registry->shaders) };
+    *lookup_shader(registry, handle) = shader;
+
+    return handle;
+}
+
+MeshHandle add_mesh(AssetRegistry *registry, Mesh *mesh)
+{
+    MeshHandle handle = { pool_alloc(&registry->meshes) };
+    Mesh *pooled = lookup_mesh(registry, handle);
+    *pooled = *mesh;
+    keep_mesh_draw_data(pooled);
+
+    return handle;
+}
+
+MaterialHandle add_material(AssetRegistry *registry, Material material)
+{
+    MaterialHandle handle = { pool_alloc(&registry->materials) };
+    *lookup_material(registry, handle) = material;
+
+    return handle;
+}
+
+Texture *lookup_texture(AssetRegistry *registry, TextureHandle handle)
+{
+    return (Texture *)pool_get(&registry->textures, handle.value);
+}
+
+Shader *lookup_shader(AssetRegistry *registry, ShaderHandle handle)
+{
+    return (Shader *)pool_get(&registry->shaders, handle.value);
+}
+
+Mesh *lookup_mesh(AssetRegistry *registry, MeshHandle handle)
+{
+    return (Mesh *)pool_get(&registry->meshes, handle.value);
+}
+
+Material *lookup_material(AssetRegistry *registry, MaterialHandle handle)
+{
+    return (Material *)pool_get(&registry->materials, handle.value);
+}
+
+// A cube for a file that can't be keyed, uncached so every call makes one the caller owns.
+static MeshHandle add_missing_mesh(AssetRegistry *registry)
+{
+    TemporaryMemory temporary = begin_temporary_memory(registry->arena);
+    Mesh *cube = generate_cube(registry->arena, 1);
+    upload_mesh(cube);
+    MeshHandle mesh = add_mesh(registry, cube);
+    end_temporary_memory(temporary);
+
+    return mesh;
+}
+
+MeshHandle get_mesh(AssetRegistry *registry, const char *file_name)
+{
+    u64 hash = FNV_OFFSET_BASIS;
+    if (!hash_path(&hash, file_name)) return add_missing_mesh(registry);
+    u64 key = make_asset_key(hash);
+
+    Asset *asset = find_asset(registry, key);
+    if (!asset->key) {
+        // everything the load pushes is copied into the pool, the arena gets it back
+        TemporaryMemory temporary = begin_temporary_memory(registry->arena);
+        MeshHandle mesh = add_mesh(registry, load_mesh_from_file(registry->arena, file_name));
+        end_temporary_memory(temporary);
+
+        add_asset(registry, asset, key, ASSET_MESH, mesh.value);
+        resolve_mesh_materials(registry, lookup_mesh(registry, mesh));
+    }
+
+    assert(asset->type == ASSET_MESH);
+    MeshHandle result = { asset->handle };
+    return result;
+}
+
+// Same cache as get_mesh, the mesh isn't resident until the streamer has uploaded it.
+MeshHandle get_streamed_mesh(AssetRegistry *registry, const char *file_name)
+{
+    u64 hash = FNV_OFFSET_BASIS;
+    if (!hash_path(&hash, file_name)) return add_missing_mesh(registry);
+    u64 key = make_asset_key(hash);
+
+    Asset *asset = find_asset(registry, key);
+    if (!asset->key)
+        add_asset(registry, asset, key, ASSET_MESH, stream_mesh(&registry->streamer, file_name).value);
+
+    assert(asset->type == ASSET_MESH);
+    MeshHandle result = { asset->handle };
+    return result;
+}
+
+TextureHandle get_texture(AssetRegistry *registry, const char *file_name)
+{
+    u64 hash = FNV_OFFSET_BASIS;
+    if (!hash_path(&hash, file_name)) return add_texture(registry, load_texture_from_memory(NULL, 0, false));
+    u64 key = make_asset_key(hash);
+
+    Asset *asset = find_asset(registry, key);
+    if (!asset->key)
+        add_asset(registry, asset, key, ASSET_TEXTURE, add_texture(registry, load_texture(file_name)).value);
+
+    assert(asset->type == ASSET_TEXTURE);
+    TextureHandle result = { asset->handle };
+    return result;
+}
+
+// A different key to get_texture's even for a whole file, the image isn't flipped.
+TextureHandle get_gltf_texture(AssetRegistry *registry, const char *file_name, u64 offset, u32 size)
+{
+    u64 hash = FNV_OFFSET_BASIS;
+    if (!hash_path(&hash, file_name)) return add_texture(registry, load_texture_from_memory(NULL, 0, false));
+    for (u32 i = 0; i < 8; i++) {
+        hash ^= (u8)(offset >> (i * 8));
+        hash *= FNV_PRIME;
+    }
+    hash ^= 'G';
+    hash *= FNV_PRIME;
+    u64 key = make_asset_key(hash);
+
+    Asset *asset = find_asset(registry, key);
+    if (!asset->key) {
+        // a file that's gone or shorter than the image gets the missing texture
+        MappedFile file = map_file(file_name);
+        b32 valid = file.data != NULL && offset + size <= file.size;
+        if (!valid) printf("%s: embedded image is missing\n", file_name);
+
+        u32 image_size = size ? size : (u32)file.size;
+        TextureHandle texture = add_texture(registry, load_texture_from_memory(valid ? file.data + offset : NULL, image_size, false));
+        add_asset(registry, asset, key, ASSET_TEXTURE, texture.value);
+        unmap_file(&file);
+    }
+
+    assert(asset->type == ASSET_TEXTURE);
+    TextureHandle result = { asset->handle };
+    return result;
+}
+
+ShaderHandle get_shader(AssetRegistry *registry, const char *vertex_file, const char *fragment_file)
+{
+    // A program is a pair of files, the fragment path carries on from the vertex path's hash.
+    // There's no missing shader, one that can't be keyed is just loaded uncached.
+    u64 hash = FNV_OFFSET_BASIS;
+    if (!hash_path(&hash, vertex_file) || !hash_path(&hash, fragment_file))
+        return add_shader(registry, load_shader_from_file(vertex_file, fragment_file));
+    u64 key = make_asset_key(hash);
+
+    Asset *asset = find_asset(registry, key);
+    if (!asset->key)
+        add_asset(registry, asset, key, ASSET_SHADER, add_shader(registry, load_shader_from_file(vertex_file, fragment_file)).value);
+
+    assert(asset->type == ASSET_SHADER);
+    ShaderHandle result = { asset->handle };
+    return result;
+}
+
+MeshHandle find_generated_mesh(AssetRegistry *registry, const char *name)
+{
+    MeshHandle result = { 0 };
+
+    Asset *asset = find_asset(registry, make_asset_key(hash_name(name)));
+    if (!asset->key) return result;
+
+    assert(asset->type == ASSET_MESH);
+    result.value = asset->handle;
+    return result;
+}
+
+MeshHandle add_generated_mesh(AssetRegistry *registry, const char *name, Mesh *mesh)
+{
+    u64 key = make_asset_key(hash_name(name));
+
+    Asset *asset = find_asset(registry, key);
+    assert(!asset->key);
+
+    MeshHandle handle = add_mesh(registry, mesh);
+    add_asset(registry, asset, key, ASSET_MESH, handle.value);
+
+    return handle;
+}
+
+void resolve_mesh_materials(AssetRegistry *registry, Mesh *mesh)
+{
+    for (u32 i = 0; i < mesh->num_material_slots; i++) {
+        MaterialSlot *slot = &mesh->material_slots[i];
+
+        TextureHandle textures[4] = { 0 };
+        b32 any = false;
+        for (u32 j = 0; j < array_count(textures); j++) {
+            if (!slot->texture_files[j][0]) continue;
+            if (slot->gltf)
+                textures[j] = get_gltf_texture(registry, slot->texture_files[j], slot->texture_offsets[j], slot->texture_sizes[j]);
+            else
+                textures[j] = get_texture(registry, slot->texture_files[j]);
+            any = true;
+        }
+        if (!any) continue;
+
+        Material material = { 0 };
+        material.albedo = textures[0];
+        material.normal = textures[1];
+        material.metalness = textures[2];
+        material.roughness = textures[3];
+        material.packed_metal_roughness = slot->packed_metal_roughness;
+        slot->material = add_material(registry, material);
+    }
+}
+
+void destroy_texture(AssetRegistry *registry, TextureHandle handle)
+{
+    Texture *texture = lookup_texture(registry, handle);
+    if (!texture) return;
+
+    glDeleteTextures(1, &texture->id);
+    track_memory(MEMORY_TAG_GL_TEXTURE, -(s64)texture->size);
+    forget_asset(registry, ASSET_TEXTURE, handle.value);
+    pool_free(&registry->textures, handle.value);
+}
+
+void destroy_shader(AssetRegistry *registry, ShaderHandle handle)
+{
+    Shader *shader = lookup_shader(registry, handle);
+    if (!shader) return;
+
+    glDeleteProgram(shader->id);
+    forget_asset(registry, ASSET_SHADER, handle.value);
+    pool_free(&registry->shaders, handle.value);
+}
+
+// A mesh still streaming in is dropped by the streamer when it finds the handle stale.
+void destroy_mesh(AssetRegistry *registry, MeshHandle handle)
+{
+    Mesh *mesh = lookup_mesh(registry, handle);
+    if (!mesh) return;
+
+    for (u32 i = 0; i < mesh->num_material_slots; i++)
+        destroy_material(registry, mesh->material_slots[i].material);
+
+    free_mesh(mesh);
+    forget_asset(registry, ASSET_MESH, handle.value);
+    pool_free(&registry->meshes, handle.value);
+}
+
+void destroy_material(AssetRegistry *registry, MaterialHandle handle)
+{
+    pool_free(&registry->materials, handle.value);
+}
@@ -0,0 +1,80 @@
+#ifndef ASSET_H
+#define ASSET_H
+
+// Capacity of each pool, asset churn reuses slots so these bound the live count not the total.
+#define MAX_TEXTURES 1024
+#define MAX_SHADERS 64
+#define MAX_MESHES 256
+#define MAX_MATERIALS 1024
+
+// Slots in the registry's table, a power of two at least twice the pools whose entries are
+// keyed on a file, so it's at most half full when they are. Materials are never keyed.
+#define ASSET_TABLE_SIZE 4096
+
+typedef enum AssetType {
+    ASSET_MESH,
+    ASSET_TEXTURE,
+    ASSET_SHADER
+} AssetType;
+
+typedef struct Asset {
+    u64 key; // hash of the canonical path, 0 marks an empty slot
+    AssetType type;
+    u32 handle; // into the pool for type
+} Asset;
+
+// Loaded assets keyed on their file, asking for the same file twice returns the first load.
+// Textures, shaders, meshes and materials live in the pools and are handed out as handles,
+// lookup turns one into a pointer that's good until the next destroy. A path too long to
+// key gets an uncached missing asset, the magenta texel or the cube.
+struct AssetRegistry {
+    MemoryArena *arena;
+    u32 count;
+    Asset slots[ASSET_TABLE_SIZE];
+
+    Pool textures;
+    Pool shaders;
+    Pool meshes;
+    Pool materials;
+
+    MeshStreamer streamer;
+};
+
+void init_asset_registry(AssetRegistry *registry, MemoryArena *arena);
+
+MeshHandle get_mesh(AssetRegistry *registry, const char *file_name);
+MeshHandle get_streamed_mesh(AssetRegistry *registry, const char *file_name);
+TextureHandle get_texture(AssetRegistry *registry, const char *file_name);
+// An image inside a glTF file or next to one, size 0 is the whole file.
+TextureHandle get_gltf_texture(AssetRegistry *registry, const char *file_name, u64 offset, u32 size);
+ShaderHandle get_shader(AssetRegistry *registry, const char *vertex_file, const char *fragment_file);
+
+// Loads the textures named by the mesh's material slots, main thread only.
+void resolve_mesh_materials(AssetRegistry *registry, Mesh *mesh);
+// Generated meshes are cached under a name rather than a file, find returns the null handle
+// until one is added. add takes the mesh over like add_mesh.
+MeshHandle find_generated_mesh(AssetRegistry *registry, const char *name);
+MeshHandle add_generated_mesh(AssetRegistry *registry, const char *name, Mesh *mesh);
+
+// Pool objects that aren't loaded from a file, nothing finds them again by name. add_mesh
+// copies the struct and its draw data out of whatever arena it was built on, after which
+// that memory can be given back.
+TextureHandle add_texture(AssetRegistry *registry, Texture texture);
+MeshHandle add_mesh(AssetRegistry *registry, Mesh *mesh);
+MaterialHandle add_material(AssetRegistry *registry, Material material);
+
+// NULL once the handle has been destroyed.
+Texture *lookup_texture(AssetRegistry *registry, TextureHandle handle);
+Shader *lookup_shader(AssetRegistry *registry, ShaderHandle handle);
+Mesh *lookup_mesh(AssetRegistry *registry, MeshHandle handle);
+Material *lookup_material(AssetRegistry *registry, MaterialHandle handle);
+
+// Releases the GL objects and the pool slot and drops the file from the cache, so asking for
+// it again loads it again. Stale handles are ignored. A mesh takes the materials its slots
+// resolved with it, textures are shared and have to be destroyed on their own.
+void destroy_texture(AssetRegistry *registry, TextureHandle handle);
+void destroy_shader(AssetRegistry *registry, ShaderHandle handle);
+void destroy_mesh(AssetRegistry *registry, MeshHandle handle);
+void destroy_material(AssetRegistry *registry, MaterialHandle handle);
+
+#endif /* ASSET_H */
@@ -68,7 +68,7 @@ void update_camera(Camera *camera, InputState *input, s32 width, s32 height)
         velocity_dir = vec3_add(velocity_dir, right(camera));
 
     if (vec3_length(velocity_dir) > 0)
-        velocity_dir = vec3_norm(velocity_dir);
+        velocity_dir = fast_vec3_norm(velocity_dir);
 
     camera->position = vec3_add(camera->position, vec3_mul_float(velocity_dir, velocity_speed));
 
@@ -77,13 +77,13 @@ void update_camera(Camera *camera, InputState *input, s32 width, s32 height)
         delta.x = (f32)(input->position.x - width / 2);
         delta.y = (f32)(input->position.y - height / 2);
 
-        Quaternion yaw = angle_axis(0.005f * to_radians(delta.x), vec3(0.0f, 1.0f, 0.0f));
-        Quaternion pitch = angle_axis(0.005f * to_radians(delta.y), right(camera));
+        Quaternion yaw = fast_angle_axis(0.005f * to_radians(delta.x), vec3(0.0f, 1.0f, 0.0f));
+        Quaternion pitch = fast_angle_axis(0.005f * to_radians(delta.y), right(camera));
 
         Quaternion rotation = quat_mul(yaw, pitch);
 
         camera->orientation = quat_mul(camera->orientation, rotation);
-        camera->orientation = quat_norm(camera->orientation);
+        camera->orientation = fast_quat_norm(camera->orientation);
     }
 
     update_camera_view(camera);
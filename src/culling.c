@@ -0,0 +1,80 @@
+#include "culling.h"
+
+// outside lanes are behind a plane by more than their radius, crossing ones are within it
+static u32 store_cull_results(lane_mask outside, lane_mask crossing, u32 count, u8 *results)
+{
+    u32 outside_bits = lane_mask_bits(outside);
+    u32 crossing_bits = lane_mask_bits(crossing);
+
+    u32 num_outside = 0;
+    for (u32 lane = 0; lane < LANE_WIDTH; lane++) {
+        u32 bit = 1u << lane;
+        if (outside_bits & bit) {
+            results[lane] = CULL_OUTSIDE;
+            if (lane < count) num_outside++;
+        } else {
+            results[lane] = (crossing_bits & bit) ? CULL_INTERSECTS : CULL_INSIDE;
+        }
+    }
+
+    return num_outside;
+}
+
+u32 cull_aabbs(Frustum *frustum, Vector3Array centres, Vector3Array extents, u32 count, u8 *results)
+{
+    u32 num_outside = 0;
+
+    for (u32 i = 0; i < count; i += LANE_WIDTH) {
+        lane_f32 cx = lane_load(centres.x + i);
+        lane_f32 cy = lane_load(centres.y + i);
+        lane_f32 cz = lane_load(centres.z + i);
+        lane_f32 ex = lane_load(extents.x + i);
+        lane_f32 ey = lane_load(extents.y + i);
+        lane_f32 ez = lane_load(extents.z + i);
+
+        lane_mask outside = lane_less(lane_set1(0.0f), lane_set1(0.0f));
+        lane_mask crossing = outside;
+
+        for (u32 j = 0; j < 6; j++) {
+            Vector4 plane = frustum->planes[j];
+
+            // the box's radius along the plane normal
+            lane_f32 distance = lane_mul_add(lane_set1(plane.x), cx, lane_mul_add(lane_set1(plane.y), cy, lane_mul_add(lane_set1(plane.z), cz, lane_set1(plane.w))));
+            lane_f32 radius = lane_mul_add(lane_set1(fabsf(plane.x)), ex, lane_mul_add(lane_set1(fabsf(plane.y)), ey, lane_mul(lane_set1(fabsf(plane.z)), ez)));
+
+            outside = lane_mask_or(outside, lane_less(lane_add(distance, radius), lane_set1(0.0f)));
+            crossing = lane_mask_or(crossing, lane_less(distance, radius));
+        }
+
+        num_outside += store_cull_results(outside, crossing, count - i, results + i);
+    }
+
+    return num_outside;
+}
+
+u32 cull_spheres(Frustum *frustum, Vector3Array centres, f32 *radii, u32 count, u8 *results)
+{
+    u32 num_outside = 0;
+
+    for (u32 i = 0; i < count; i += LANE_WIDTH) {
+        lane_f32 cx = lane_load(centres.x + i);
+        lane_f32 cy = lane_load(centres.y + i);
+        lane_f32 cz = lane_load(centres.z + i);
+        lane_f32 radius = lane_load(radii + i);
+
+        lane_mask outside = lane_less(lane_set1(0.0f), lane_set1(0.0f));
+        lane_mask crossing = outside;
+
+        for (u32 j = 0; j < 6; j++) {
+            Vector4 plane = frustum->planes[j];
+            lane_f32 distance = lane_mul_add(lane_set1(plane.x), cx, lane_mul_add(lane_set1(plane.y), cy, lane_mul_add(lane_set1(plane.z), cz, lane_set1(plane.w))));
+
+            outside = lane_mask_or(outside, lane_less(lane_add(distance, radius), lane_set1(0.0f)));
+            crossing = lane_mask_or(crossing, lane_less(distance, radius));
+        }
+
+        num_outside += store_cull_results(outside, crossing, count - i, results + i);
+    }
+
+    return num_outside;
+}
@@ -0,0 +1,18 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+// Where a bound is against a frustum. Like frustum_contains_aabb the test is per plane, so
+// a bound near a corner of the frustum can come out intersecting when it's outside.
+typedef enum CullResult {
+    CULL_OUTSIDE,
+    CULL_INTERSECTS,
+    CULL_INSIDE
+} CullResult;
+
+// Sorts LANE_WIDTH bounds at a time into results, one CullResult each, and returns how
+// many are outside. The arrays are padded to whole lanes, results too. Boxes are centres
+// and half extents.
+u32 cull_aabbs(Frustum *frustum, Vector3Array centres, Vector3Array extents, u32 count, u8 *results);
+u32 cull_spheres(Frustum *frustum, Vector3Array centres, f32 *radii, u32 count, u8 *results);
+
+#endif /* CULLING_H */
@@ -1,17 +1,78 @@
-#include "platform.h"
-
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
+#include "platform.h"
+
+// refreshed on every call into the dll so subsystems can reach the platform services
+static Platform *global_platform;
+
+// Set while a streaming load runs. Each queue only takes work from one thread, so the
+// load's parallel stages go to the stream queue instead of the main thread's.
+static __declspec(thread) b32 global_on_streaming_thread;
+
+static u32 get_worker_count(void)
+{
+    return global_on_streaming_thread ? global_platform->stream_worker_count : global_platform->worker_count;
+}
+
+static PlatformWorkQueue *get_work_queue(void)
+{
+    return global_on_streaming_thread ? global_platform->stream_queue : global_platform->work_queue;
+}
+
+// Where chunk i of num_chunks starts when total items are split evenly, chunk i ends where
+// i + 1 starts.
+inline u64 get_chunk_start(u64 total, u32 i, u32 num_chunks) { return (total * i) / num_chunks; }
+
+// Runs callback on each of the count chunks, stride bytes apart, on the work queue when
+// there are workers and inline otherwise.
+static void run_chunks(PlatformWorkQueueCallback *callback, void *chunks, usize stride, u32 count)
+{
+    u8 *at = (u8 *)chunks;
+    if (count > 1 && get_worker_count() > 0) {
+        PlatformWorkQueue *queue = get_work_queue();
+        for (u32 i = 0; i < count; i++)
+            global_platform->add_work_entry(queue, callback, at + i * stride);
+        global_platform->complete_all_work(queue);
+    } else {
+        for (u32 i = 0; i < count; i++)
+            callback(NULL, at + i * stride);
+    }
+}
+
 #include "memory.h"
+#include "pool.h"
 #include "opengl.h"
 #include "mesh.h"
+#include "mesh_optimise.h"
+#include "meshlet.h"
+#include "mesh_tangent.h"
+#include "mesh_simplify.h"
+#include "mesh_stream.h"
+#include "mesh_primitive.h"
+#include "json.h"
+#include "mesh_gltf.h"
+#include "asset.h"
 #include "camera.h"
+#include "transform.h"
+#include "culling.h"
 
 #include "memory.c"
+#include "pool.c"
 #include "opengl.c"
 #include "mesh.c"
+#include "mesh_optimise.c"
+#include "meshlet.c"
+#include "mesh_tangent.c"
+#include "mesh_simplify.c"
+#include "mesh_stream.c"
+#include "mesh_primitive.c"
+#include "json.c"
+#include "mesh_gltf.c"
+#include "asset.c"
 #include "camera.c"
+#include "transform.c"
+#include "culling.c"
 
 #include "epsilon.h"
 
@@ -19,6 +80,12 @@ static GameState *game_state;
 
 static f32 rotate_speed = 0.0f;
 
+static void print_memory_usage(void)
+{
+    print_memory_stats();
+    printf("asset arena %zu KB used, %zu KB committed\n", game_state->assets.used / 1024, game_state->assets.committed / 1024);
+}
+
 static void handle_events(Platform *platform)
 {
     for (u32 i = 0; i < platform->event_count; i++) {
@@ -29,40 +96,79 @@ static void handle_events(Platform *platform)
 
 __declspec(dllexport) void init_game(Platform *platform)
 {
+    global_platform = platform;
     load_opengl_functions(platform);
 
+    if (CHECK_FAST_MATHS) check_fast_maths();
+
     game_state = (GameState *)platform->permanent_arena;
     if (game_state) platform->initialised = true;
 
-    alloc_arena(&game_state->assets, platform->permanent_arena_size - sizeof(game_state), (u64 *)platform->permanent_arena + sizeof(game_state));
+    // the arena starts after the whole GameState, not after a pointer to it
+    usize assets_size = platform->permanent_arena_size - sizeof(GameState);
+    u8 *assets_base = (u8 *)platform->permanent_arena + sizeof(GameState);
+    if (platform->permanent_arena_committed) {
+        alloc_arena(&game_state->assets, assets_size, assets_base);
+    } else {
+        // GameState shares its last page with the asset arena, committing that twice is harmless
+        b32 committed = platform->commit_memory(game_state, sizeof(GameState));
+        assert(committed);
+        reserve_arena(&game_state->assets, assets_size, assets_base, platform->commit_memory);
+    }
+    global_memory_stats = &game_state->memory_stats;
+    global_thread_scratches = &game_state->thread_scratches;
+    sub_arena(&game_state->frame_arenas[0], &game_state->assets, FRAME_ARENA_SIZE);
+    sub_arena(&game_state->frame_arenas[1], &game_state->assets, FRAME_ARENA_SIZE);
+
+    init_asset_registry(&game_state->registry, &game_state->assets);
+    AssetRegistry *registry = &game_state->registry;
+
+    game_state->sky_box = load_cube(registry);
+    game_state->sky_box_shader = get_shader(registry, "../assets/shaders/skybox_vertex.glsl", "../assets/shaders/skybox_fragment.glsl");
+    game_state->environment = generate_texture_cubemap(registry, "../assets/textures/environment.hdr");
 
-    game_state->sky_box = create_skybox(&game_state->assets, "../assets/textures/environment.hdr");
+    init_transform_batch(&game_state->transforms, &game_state->assets, MAX_TRANSFORMS);
 
-    game_state->model = load_mesh_from_file(&game_state->assets, "../assets/meshes/cerberus/cerberus.obj");
-    game_state->model->shader = load_shader_from_file(&game_state->assets, "../assets/shaders/pbr_vertex.glsl", "../assets/shaders/pbr_fragment.glsl");
-    game_state->model->material = push_struct(&game_state->assets, Material);
-    game_state->model->material->albedo = load_texture(&game_state->assets, "../assets/meshes/cerberus/cerberus_A.tga");
-    game_state->model->material->normal = load_texture(&game_state->assets, "../assets/meshes/cerberus/cerberus_N.tga");
-    game_state->model->material->metalness = load_texture(&game_state->assets, "../assets/meshes/cerberus/cerberus_M.tga");
-    game_state->model->material->roughness = load_texture(&game_state->assets, "../assets/meshes/cerberus/cerberus_R.tga");
+    game_state->model = get_streamed_mesh(registry, "../assets/meshes/cerberus/cerberus.obj");
+    game_state->model_transform = add_transform(&game_state->transforms, vec3(0.0f, 0.0f, 0.0f), angle_axis(0.0f, vec3(0.0f, 1.0f, 0.0f)), vec3(1.0f, 1.0f, 1.0f));
+    Material material = { 0 };
+    material.albedo = get_texture(registry, "../assets/meshes/cerberus/cerberus_A.tga");
+    material.normal = get_texture(registry, "../assets/meshes/cerberus/cerberus_N.tga");
+    material.metalness = get_texture(registry, "../assets/meshes/cerberus/cerberus_M.tga");
+    material.roughness = get_texture(registry, "../assets/meshes/cerberus/cerberus_R.tga");
+
+    Mesh *model = lookup_mesh(registry, game_state->model);
+    model->shader = get_shader(registry, "../assets/shaders/pbr_vertex.glsl", "../assets/shaders/pbr_fragment.glsl");
+    model->material = add_material(registry, material);
 
     // enviroment textures
-    game_state->irradiance = generate_texture_irradiance(&game_state->assets, game_state->sky_box->texture);
-    game_state->prefilter = generate_texture_prefilter(&game_state->assets, game_state->sky_box->texture);
-    game_state->brdf = generate_texture_brdf(&game_state->assets);
+    game_state->irradiance = generate_texture_irradiance(registry, game_state->environment);
+    game_state->prefilter = generate_texture_prefilter(registry, game_state->environment);
+    game_state->brdf = generate_texture_brdf(registry);
 
     Matrix4x4 projection = mat4_perspective(to_radians(45.0f), (f32)(platform->width / platform->height), 0.1f, 100.0f);
     game_state->camera = init_camera(&game_state->assets, projection);
+
+    print_memory_usage();
 }
 
 __declspec(dllexport) void update_game(Platform *platform)
 {
+    global_platform = platform;
     if (!game_state) {
         game_state = (GameState *)platform->permanent_arena;
+        global_memory_stats = &game_state->memory_stats;
+        global_thread_scratches = &game_state->thread_scratches;
         load_opengl_functions(platform);
     }
 
+    // per frame scratch is a pointer bump, whatever the previous frame pushed is still there
+    game_state->frame_index ^= 1;
+    MemoryArena *frame_arena = &game_state->frame_arenas[game_state->frame_index];
+    reset_arena(frame_arena);
+
     handle_events(platform);
+    update_mesh_streamer(&game_state->registry.streamer);
 
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -72,57 +178,89 @@ __declspec(dllexport) void update_game(Platform *platform)
 
     // render models
     rotate_speed += 0.01f;
-    Matrix4x4 trans = mat4_translate(vec3(0.0f, 0.0f, 0.0f));
-    //trans = mat4_mul(trans, mat4_scale(vec3(0.5f, 0.5f, 0.5f)));
-    trans = mat4_mul(trans, mat4_rotate(rotate_speed, vec3(0.0f, 1.0f, 0.0f)));
-
-    glUseProgram(game_state->model->shader->id);
-    set_uniform_mat4(game_state->model->shader->id, "model", trans);
-    set_uniform_mat4(game_state->model->shader->id, "view", game_state->camera->view_matrix);
-    set_uniform_mat4(game_state->model->shader->id, "projection", game_state->camera->projection_matrix);
-
-    set_uniform_vec3(game_state->model->shader->id, "light.direction", vec3(1.0f, 0.0f, 1.0f));
-    set_uniform_vec3(game_state->model->shader->id, "light.radiance", vec3(0.5f, 0.5f, 0.5f));
-
-    set_uniform_int(game_state->model->shader->id, "albedo_texture", 0);
-    set_uniform_int(game_state->model->shader->id, "normal_texture", 1);
-    set_uniform_int(game_state->model->shader->id, "metalness_texture", 2);
-    set_uniform_int(game_state->model->shader->id, "roughness_texture", 3);
-    set_uniform_int(game_state->model->shader->id, "irradiance_map", 4);
-    set_uniform_int(game_state->model->shader->id, "prefilter_map", 5);
-    set_uniform_int(game_state->model->shader->id, "brdf_lut_map", 6);
-
-    set_uniform_vec3(game_state->model->shader->id, "camera_position", game_state->camera->position);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, game_state->model->material->albedo->id);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, game_state->model->material->normal->id);
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, game_state->model->material->metalness->id);
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, game_state->model->material->roughness->id);
-    glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, game_state->irradiance->id);
-    glActiveTexture(GL_TEXTURE5);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, game_state->prefilter->id);
-    glActiveTexture(GL_TEXTURE6);
-    glBindTexture(GL_TEXTURE_2D, game_state->brdf->id);
-    glBindVertexArray(game_state->model->vertex_array);
-    glDrawElements(GL_TRIANGLES, game_state->model->num_indices, GL_UNSIGNED_INT, 0);
+    TransformBatch *transforms = &game_state->transforms;
+    set_transform(transforms, game_state->model_transform, vec3(0.0f, 0.0f, 0.0f), angle_axis(rotate_speed, vec3(0.0f, 1.0f, 0.0f)), vec3(1.0f, 1.0f, 1.0f));
+
+    AssetRegistry *registry = &game_state->registry;
+    Mesh *model = lookup_mesh(registry, game_state->model);
+    if (model && model->resident) set_transform_bounds(transforms, game_state->model_transform, model->bounds);
+
+    // every object's matrices and world bounds in one go
+    Matrix4x4 view_projection = mat4_mul(game_state->camera->projection_matrix, game_state->camera->view_matrix);
+    TransformResults transformed = compute_transforms(frame_arena, transforms, view_projection);
+    u32 index = game_state->model_transform;
+    Matrix4x4 trans = transformed.world[index];
+
+    // objects wholly outside the view aren't drawn, wholly inside ones skip the finer culling
+    Frustum view_frustum = frustum_from_mat4(view_projection);
+    u8 *visibility = push_array(frame_arena, lane_count(transformed.count), u8);
+    u32 culled_objects = cull_aabbs(&view_frustum, transformed.bounds_centres, transformed.bounds_extents, transformed.count, visibility);
+    CullCounts culled = { 0 };
+
+    // streamed meshes join the draw once they're resident
+    if (model && model->resident && visibility[index] != CULL_OUTSIDE) {
+        GLuint shader_id = lookup_shader(registry, model->shader)->id;
+        glUseProgram(shader_id);
+        set_uniform_mat4(shader_id, "model", trans);
+        set_uniform_mat4(shader_id, "mvp", transformed.mvp[index]);
+        set_uniform_mat3(shader_id, "normal_matrix", transformed.normal[index]);
+
+        set_uniform_vec3(shader_id, "light.direction", vec3(1.0f, 0.0f, 1.0f));
+        set_uniform_vec3(shader_id, "light.radiance", vec3(0.5f, 0.5f, 0.5f));
+
+        set_uniform_int(shader_id, "albedo_texture", 0);
+        set_uniform_int(shader_id, "normal_texture", 1);
+        set_uniform_int(shader_id, "metalness_texture", 2);
+        set_uniform_int(shader_id, "roughness_texture", 3);
+        set_uniform_int(shader_id, "irradiance_map", 4);
+        set_uniform_int(shader_id, "prefilter_map", 5);
+        set_uniform_int(shader_id, "brdf_lut_map", 6);
+
+        set_uniform_vec3(shader_id, "camera_position", game_state->camera->position);
+        set_mesh_uniforms(shader_id, model);
+
+        // units 0 to 3 are the material's, draw_submeshes binds them per material slot
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, lookup_texture(registry, game_state->irradiance)->id);
+        glActiveTexture(GL_TEXTURE5);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, lookup_texture(registry, game_state->prefilter)->id);
+        glActiveTexture(GL_TEXTURE6);
+        glBindTexture(GL_TEXTURE_2D, lookup_texture(registry, game_state->brdf)->id);
+        glBindVertexArray(model->vertex_array);
+
+        // pick the coarsest level whose error stays under a pixel at the nearest point of the bounds
+        Vector3 model_centre = vec3(transformed.bounds_centres.x[index], transformed.bounds_centres.y[index], transformed.bounds_centres.z[index]);
+        f32 model_radius = vec3_length(aabb_extents(model->bounds));
+        f32 model_distance = vec3_length(vec3_sub(model_centre, game_state->camera->position)) - model_radius;
+        f32 pixels_per_unit = game_state->camera->projection_matrix.elements[1][1] * (f32)platform->height * 0.5f;
+        u32 lod = select_mesh_lod(model, fmaxf(model_distance, 0.1f), pixels_per_unit);
+
+        // cull in model space, the camera goes there through the inverse of the model's transform
+        Frustum frustum = frustum_from_mat4(transformed.mvp[index]);
+        Matrix4x4 inverse_trans = mat4_inverse_affine(trans);
+        Vector4 camera_position = mat4_mul_vec4(inverse_trans, vec4(game_state->camera->position.x, game_state->camera->position.y, game_state->camera->position.z, 1.0f));
+        Frustum *model_frustum = (visibility[index] == CULL_INSIDE) ? NULL : &frustum;
+        culled = draw_submeshes(registry, frame_arena, model, lod, model_frustum, vec3(camera_position.x, camera_position.y, camera_position.z));
+    }
+
+    snprintf(platform->frame_info, sizeof(platform->frame_info), "culled %u/%u objects, %u submeshes, %u meshlets",
+        culled_objects, transformed.count, culled.submeshes, culled.meshlets);
 
     // render skybox
     glDepthFunc(GL_LEQUAL);
 
     Matrix4x4 view = mat4_from_mat3(mat3(game_state->camera->view_matrix));
 
-    glUseProgram(game_state->sky_box->shader->id);
-    set_uniform_mat4(game_state->sky_box->shader->id, "view", view);
-    set_uniform_mat4(game_state->sky_box->shader->id, "projection", game_state->camera->projection_matrix);
+    Mesh *sky_box = lookup_mesh(registry, game_state->sky_box);
+    GLuint sky_box_shader_id = lookup_shader(registry, game_state->sky_box_shader)->id;
+    glUseProgram(sky_box_shader_id);
+    set_uniform_mat4(sky_box_shader_id, "view", view);
+    set_uniform_mat4(sky_box_shader_id, "projection", game_state->camera->projection_matrix);
+    set_mesh_uniforms(sky_box_shader_id, sky_box);
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, game_state->sky_box->texture->id);
-    glBindVertexArray(game_state->sky_box->vertex_array);
-    glDrawElements(GL_TRIANGLES, game_state->sky_box->num_indices, GL_UNSIGNED_INT, 0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, lookup_texture(registry, game_state->environment)->id);
+    glBindVertexArray(sky_box->vertex_array);
+    draw_mesh_lod(sky_box, 0);
 
     glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
@@ -133,5 +271,9 @@ __declspec(dllexport) void update_game(Platform *platform)
 
 __declspec(dllexport) void shutdown_game()
 {
+    if (!game_state) return;
 
+    release_mesh_streamer(&game_state->registry.streamer);
+    release_thread_scratches();
+    print_memory_usage();
 }
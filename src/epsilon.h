@@ -1,18 +1,36 @@
 #ifndef EPSILON_H
 #define EPSILON_H
 
+// Scratch for one frame, double buffered so what a frame pushed lives through the next.
+#define FRAME_ARENA_SIZE megabytes(16)
+
+#define MAX_TRANSFORMS 4096
+
 typedef struct GameState {
+    MemoryStats memory_stats; // here so they survive reloading the dll
+    ThreadScratches thread_scratches; // likewise, the threads keep running across a reload
     MemoryArena assets;
 
-    Mesh *model;
-    Mesh *sky_box;
-    Mesh *box;
-    Mesh *sphere;
+    MemoryArena frame_arenas[2];
+    u32 frame_index;
+    AssetRegistry registry;
+
+    TransformBatch transforms;
+    u32 model_transform;
+
+    MeshHandle model;
+    MeshHandle box;
+    MeshHandle sphere;
+
+    // the registry's cube drawn with the environment map
+    MeshHandle sky_box;
+    ShaderHandle sky_box_shader;
+    TextureHandle environment;
 
     // Scene struct?
-    Texture *irradiance;
-    Texture *prefilter;
-    Texture *brdf;
+    TextureHandle irradiance;
+    TextureHandle prefilter;
+    TextureHandle brdf;
 
     Camera *camera;
 } GameState;
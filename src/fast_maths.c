@@ -0,0 +1,237 @@
+#include "fast_maths.h"
+
+// 11 and 10 degree minimax polynomials for sin and cos on [-pi/2, pi/2]
+#define SIN_C1 -0.16666667f
+#define SIN_C2 0.0083333310f
+#define SIN_C3 -0.00019840874f
+#define SIN_C4 2.7525562e-06f
+#define SIN_C5 -2.3889859e-08f
+
+#define COS_C1 -0.5f
+#define COS_C2 0.041666638f
+#define COS_C3 -0.0013888378f
+#define COS_C4 2.4760495e-05f
+#define COS_C5 -2.6051615e-07f
+
+#define TWO_PI 6.28318530718f
+#define HALF_PI 1.57079632679f
+
+// 2 pi in two parts, the first with few enough bits that whole turns times it are exact
+#define TWO_PI_HIGH 6.28125f
+#define TWO_PI_LOW 0.00193530717958647692f
+
+inline f32 fast_rsqrt(f32 x)
+{
+    f32 y = USE_SIMD_MATHS ? _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x))) : 1.0f / sqrtf(x);
+
+    // one Newton step takes the 12 bit estimate to about 22
+    return y * (1.5f - 0.5f * x * y * y);
+}
+
+inline void fast_sin_cos(f32 x, f32 *sine, f32 *cosine)
+{
+    // into [-pi, pi], then folded into [-pi/2, pi/2] where the polynomials hold, which
+    // keeps the sine and flips the cosine
+    f32 turns = floorf(x * (1.0f / TWO_PI) + 0.5f);
+    f32 y = (x - turns * TWO_PI_HIGH) - turns * TWO_PI_LOW;
+    f32 sign = 1.0f;
+    if (y > HALF_PI) {
+        y = PI - y;
+        sign = -1.0f;
+    } else if (y < -HALF_PI) {
+        y = -PI - y;
+        sign = -1.0f;
+    }
+
+    f32 y2 = y * y;
+    *sine = (((((SIN_C5 * y2 + SIN_C4) * y2 + SIN_C3) * y2 + SIN_C2) * y2 + SIN_C1) * y2 + 1.0f) * y;
+    *cosine = sign * (((((COS_C5 * y2 + COS_C4) * y2 + COS_C3) * y2 + COS_C2) * y2 + COS_C1) * y2 + 1.0f);
+}
+
+inline f32 fast_sin(f32 x)
+{
+    f32 sine, cosine;
+    fast_sin_cos(x, &sine, &cosine);
+    return sine;
+}
+
+inline f32 fast_cos(f32 x)
+{
+    f32 sine, cosine;
+    fast_sin_cos(x, &sine, &cosine);
+    return cosine;
+}
+
+inline f32 fast_tan(f32 x)
+{
+    f32 sine, cosine;
+    fast_sin_cos(x, &sine, &cosine);
+    return sine / cosine;
+}
+
+inline Vector3 fast_vec3_norm(Vector3 v)
+{
+    return vec3_mul_float(v, fast_rsqrt(vec3_length_sq(v)));
+}
+
+inline Quaternion fast_quat_norm(Quaternion q)
+{
+    return quat_mul_float(q, fast_rsqrt(quat_length_sq(q)));
+}
+
+inline Quaternion fast_angle_axis(f32 angle, Vector3 axis)
+{
+    axis = fast_vec3_norm(axis);
+
+    f32 s, c;
+    fast_sin_cos(angle * 0.5f, &s, &c);
+
+    Quaternion result;
+    result.x = axis.x * s;
+    result.y = axis.y * s;
+    result.z = axis.z * s;
+    result.w = c;
+
+    return result;
+}
+
+inline lane_f32 fast_rsqrt_lanes(lane_f32 x)
+{
+    lane_f32 y = lane_rsqrt_estimate(x);
+    lane_f32 xyy = lane_mul(x, lane_mul(y, y));
+    return lane_mul(y, lane_sub(lane_set1(1.5f), lane_mul(lane_set1(0.5f), xyy)));
+}
+
+void fast_rsqrt_array(f32 *values, u32 count, f32 *results)
+{
+    for (u32 i = 0; i < count; i += LANE_WIDTH)
+        lane_store(results + i, fast_rsqrt_lanes(lane_load(values + i)));
+}
+
+void fast_sin_cos_array(f32 *angles, u32 count, f32 *sines, f32 *cosines)
+{
+    lane_f32 one = lane_set1(1.0f);
+    lane_f32 pi = lane_set1(PI);
+    lane_f32 half_pi = lane_set1(HALF_PI);
+
+    for (u32 i = 0; i < count; i += LANE_WIDTH) {
+        lane_f32 x = lane_load(angles + i);
+
+        // the same steps as fast_sin_cos, with the branches as selects
+        lane_f32 turns = lane_round(lane_mul(x, lane_set1(1.0f / TWO_PI)));
+        lane_f32 y = lane_sub(lane_sub(x, lane_mul(turns, lane_set1(TWO_PI_HIGH))), lane_mul(turns, lane_set1(TWO_PI_LOW)));
+        lane_mask above = lane_greater(y, half_pi);
+        lane_mask below = lane_less(y, lane_sub(lane_set1(0.0f), half_pi));
+        lane_f32 sign = lane_select(above, lane_set1(-1.0f), lane_select(below, lane_set1(-1.0f), one));
+        y = lane_select(above, lane_sub(pi, y), y);
+        y = lane_select(below, lane_sub(lane_sub(lane_set1(0.0f), pi), y), y);
+
+        lane_f32 y2 = lane_mul(y, y);
+        lane_f32 s = lane_mul_add(lane_set1(SIN_C5), y2, lane_set1(SIN_C4));
+        s = lane_mul_add(s, y2, lane_set1(SIN_C3));
+        s = lane_mul_add(s, y2, lane_set1(SIN_C2));
+        s = lane_mul_add(s, y2, lane_set1(SIN_C1));
+        s = lane_mul(lane_mul_add(s, y2, one), y);
+
+        lane_f32 c = lane_mul_add(lane_set1(COS_C5), y2, lane_set1(COS_C4));
+        c = lane_mul_add(c, y2, lane_set1(COS_C3));
+        c = lane_mul_add(c, y2, lane_set1(COS_C2));
+        c = lane_mul_add(c, y2, lane_set1(COS_C1));
+        c = lane_mul(lane_mul_add(c, y2, one), sign);
+
+        lane_store(sines + i, s);
+        lane_store(cosines + i, c);
+    }
+}
+
+void fast_normalise_array(f32 *x, f32 *y, f32 *z, u32 count)
+{
+    for (u32 i = 0; i < count; i += LANE_WIDTH) {
+        lane_f32 vx = lane_load(x + i);
+        lane_f32 vy = lane_load(y + i);
+        lane_f32 vz = lane_load(z + i);
+
+        lane_f32 length_sq = lane_mul_add(vx, vx, lane_mul_add(vy, vy, lane_mul(vz, vz)));
+        lane_f32 scale = fast_rsqrt_lanes(length_sq);
+
+        lane_store(x + i, lane_mul(vx, scale));
+        lane_store(y + i, lane_mul(vy, scale));
+        lane_store(z + i, lane_mul(vz, scale));
+    }
+}
+
+#define FAST_MATHS_CHECK_BATCH 1024
+
+// Runs the queued inputs through the array versions, returns the worst sin/cos error.
+static f64 check_sin_cos_array(f32 *angles, u32 count)
+{
+    f32 sines[FAST_MATHS_CHECK_BATCH], cosines[FAST_MATHS_CHECK_BATCH];
+    fast_sin_cos_array(angles, count, sines, cosines);
+
+    f64 worst = 0.0;
+    for (u32 i = 0; i < count; i++) {
+        f64 error = fmax(fabs(sines[i] - sin((f64)angles[i])), fabs(cosines[i] - cos((f64)angles[i])));
+        if (error > worst) worst = error;
+    }
+    return worst;
+}
+
+void check_fast_maths(void)
+{
+    f32 batch[FAST_MATHS_CHECK_BATCH], results[FAST_MATHS_CHECK_BATCH];
+    u32 count = 0;
+
+    // rsqrt(4x) is rsqrt(x) / 2 with the same rounding, so [1, 4) covers every input
+    f64 worst_rsqrt = 0.0, worst_rsqrt_array = 0.0;
+    for (f32 x = 1.0f; x < 4.0f; x = nextafterf(x, 5.0f)) {
+        f64 error = fabs(fast_rsqrt(x) * sqrt((f64)x) - 1.0);
+        if (error > worst_rsqrt) worst_rsqrt = error;
+
+        batch[count++] = x;
+        if (count == FAST_MATHS_CHECK_BATCH || nextafterf(x, 5.0f) >= 4.0f) {
+            fast_rsqrt_array(batch, count, results);
+            for (u32 i = 0; i < count; i++) {
+                error = fabs(results[i] * sqrt((f64)batch[i]) - 1.0);
+                if (error > worst_rsqrt_array) worst_rsqrt_array = error;
+            }
+            count = 0;
+        }
+    }
+
+    // every float from 0 to 1000 and its negation, in order of their bits
+    f64 worst_sin_cos = 0.0, worst_sin_cos_array = 0.0, worst_tan = 0.0;
+    for (u32 bits = 0;; bits++) {
+        f32 x;
+        memcpy(&x, &bits, sizeof(x));
+        if (!(x <= 1000.0f)) break;
+
+        for (u32 sign = 0; sign < 2; sign++) {
+            f32 angle = sign ? -x : x;
+
+            f32 sine, cosine;
+            fast_sin_cos(angle, &sine, &cosine);
+            f64 exact_sine = sin((f64)angle), exact_cosine = cos((f64)angle);
+            f64 error = fmax(fabs(sine - exact_sine), fabs(cosine - exact_cosine));
+            if (error > worst_sin_cos) worst_sin_cos = error;
+
+            if (x > 0.0f && x <= 1.5f) {
+                f64 exact_tan = exact_sine / exact_cosine;
+                error = fabs((fast_tan(angle) - exact_tan) / exact_tan);
+                if (error > worst_tan) worst_tan = error;
+            }
+
+            batch[count++] = angle;
+            if (count == FAST_MATHS_CHECK_BATCH) {
+                worst_sin_cos_array = fmax(worst_sin_cos_array, check_sin_cos_array(batch, count));
+                count = 0;
+            }
+        }
+    }
+    if (count) worst_sin_cos_array = fmax(worst_sin_cos_array, check_sin_cos_array(batch, count));
+
+    printf("fast maths, %d lanes: rsqrt %.3g (array %.3g), sin_cos %.3g (array %.3g), tan %.3g\n",
+        LANE_WIDTH, worst_rsqrt, worst_rsqrt_array, worst_sin_cos, worst_sin_cos_array, worst_tan);
+    assert(worst_rsqrt < 3e-7 && worst_rsqrt_array < 3e-7);
+    assert(worst_sin_cos < 3e-7 && worst_sin_cos_array < 3e-7);
+    assert(worst_tan < 2e-6);
+}
@@ -0,0 +1,37 @@
+#ifndef FAST_MATHS_H
+#define FAST_MATHS_H
+
+// Approximations for hot loops to opt in to, everything else keeps the libm versions.
+// The bounds are the worst check_fast_maths finds over every float in the range, it's
+// been run with SSE and with AVX2.
+//
+// fast_rsqrt    relative error under 3e-7 for x > 0, the hardware estimate and a Newton step
+// fast_sin_cos  absolute error under 3e-7 for |x| <= 1000, one range reduction for both and
+//               then minimax polynomials on [-pi/2, pi/2]
+// fast_tan      sin / cos, relative error under 2e-6 for |x| <= 1.5, it grows towards the poles
+//
+// The array versions hold to the same bounds, their arrays are padded to whole lanes.
+
+inline f32 fast_rsqrt(f32 x);
+inline void fast_sin_cos(f32 x, f32 *sine, f32 *cosine);
+inline f32 fast_sin(f32 x);
+inline f32 fast_cos(f32 x);
+inline f32 fast_tan(f32 x);
+
+inline Vector3 fast_vec3_norm(Vector3 v);
+inline Quaternion fast_quat_norm(Quaternion q);
+inline Quaternion fast_angle_axis(f32 angle, Vector3 axis);
+
+void fast_rsqrt_array(f32 *values, u32 count, f32 *results);
+void fast_sin_cos_array(f32 *angles, u32 count, f32 *sines, f32 *cosines);
+// in place, x y and z are the components of count vectors
+void fast_normalise_array(f32 *x, f32 *y, f32 *z, u32 count);
+
+// 1 runs check_fast_maths from init_game. It goes through about two billion floats against
+// the double precision libm and takes minutes, so it's for when the approximations change.
+#define CHECK_FAST_MATHS 0
+
+// Prints the worst errors over the ranges above and asserts they're inside the bounds.
+void check_fast_maths(void);
+
+#endif /* FAST_MATHS_H */
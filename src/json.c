@@ -0,0 +1,190 @@
+#include "json.h"
+
+typedef struct JsonParser {
+    char *text;
+    u32 at, end;
+
+    // the array never moves as it grows, tokens stays good
+    GrowableArray array;
+    JsonToken *tokens;
+} JsonParser;
+
+inline b32 is_json_whitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+static void skip_json_whitespace(JsonParser *parser)
+{
+    while (parser->at < parser->end && is_json_whitespace(parser->text[parser->at])) parser->at++;
+}
+
+static u32 push_json_token(JsonParser *parser, JsonType type, u32 start)
+{
+    JsonToken *token = array_add(&parser->array, 1, JsonToken);
+    memset(token, 0, sizeof(JsonToken));
+    token->type = type;
+    token->start = start;
+
+    return (u32)parser->array.count - 1;
+}
+
+static b32 parse_json_value(JsonParser *parser, u32 depth)
+{
+    skip_json_whitespace(parser);
+    if (parser->at >= parser->end || depth > JSON_MAX_DEPTH) return false;
+
+    char *text = parser->text;
+    char c = text[parser->at];
+    u32 token;
+
+    if (c == '{' || c == '[') {
+        b32 object = (c == '{');
+        char close = object ? '}' : ']';
+        token = push_json_token(parser, object ? JSON_OBJECT : JSON_ARRAY, parser->at++);
+
+        skip_json_whitespace(parser);
+        if (parser->at < parser->end && text[parser->at] == close) {
+            parser->at++;
+        } else {
+            for (;;) {
+                if (object) {
+                    skip_json_whitespace(parser);
+                    if (parser->at >= parser->end || text[parser->at] != '"') return false;
+                    if (!parse_json_value(parser, depth + 1)) return false;
+
+                    skip_json_whitespace(parser);
+                    if (parser->at >= parser->end || text[parser->at] != ':') return false;
+                    parser->at++;
+                }
+
+                if (!parse_json_value(parser, depth + 1)) return false;
+                parser->tokens[token].count++;
+
+                skip_json_whitespace(parser);
+                if (parser->at >= parser->end) return false;
+                c = text[parser->at++];
+                if (c == close) break;
+                if (c != ',') return false;
+            }
+        }
+    } else if (c == '"') {
+        token = push_json_token(parser, JSON_STRING, ++parser->at);
+        while (parser->at < parser->end && text[parser->at] != '"') {
+            if (text[parser->at] == '\\') parser->at++;
+            parser->at++;
+        }
+        if (parser->at >= parser->end) return false;
+        parser->tokens[token].end = parser->at++;
+    } else {
+        token = push_json_token(parser, JSON_PRIMITIVE, parser->at);
+        while (parser->at < parser->end) {
+            c = text[parser->at];
+            if (is_json_whitespace(c) || c == ',' || c == '}' || c == ']' || c == ':') break;
+            parser->at++;
+        }
+        if (parser->at == parser->tokens[token].start) return false;
+        parser->tokens[token].end = parser->at;
+    }
+
+    if (parser->tokens[token].type == JSON_OBJECT || parser->tokens[token].type == JSON_ARRAY)
+        parser->tokens[token].end = parser->at;
+    parser->tokens[token].next = (u32)parser->array.count;
+
+    return true;
+}
+
+b32 parse_json(Json *json, char *text, u32 length)
+{
+    // every token starts on a character of its own, so there can't be more than the length,
+    // and each is an element of at most one array
+    memset(json, 0, sizeof(Json));
+    reserve_scratch_arena(&json->arena, ((usize)length + 1) * (sizeof(JsonToken) + sizeof(u32)));
+
+    JsonParser parser = { 0 };
+    parser.text = text;
+    parser.end = length;
+    parser.array = begin_array(&json->arena, JsonToken);
+    parser.tokens = (JsonToken *)parser.array.base;
+
+    b32 valid = parse_json_value(&parser, 0);
+    skip_json_whitespace(&parser);
+
+    // GLB pads its JSON with spaces, trailing NULs come from tools that got that wrong
+    while (parser.at < parser.end && text[parser.at] == 0) parser.at++;
+    if (!valid || parser.at != parser.end) {
+        free_json(json);
+        return false;
+    }
+
+    json->text = text;
+    json->tokens = parser.tokens;
+    json->num_tokens = (u32)parser.array.count;
+
+    json->elements = push_array(&json->arena, json->num_tokens, u32);
+    u32 num_elements = 0;
+    for (u32 i = 0; i < json->num_tokens; i++) {
+        JsonToken *token = &json->tokens[i];
+        if (token->type != JSON_ARRAY) continue;
+
+        token->elements = num_elements;
+        u32 element = i + 1;
+        for (u32 j = 0; j < token->count; j++) {
+            json->elements[num_elements++] = element;
+            element = json->tokens[element].next;
+        }
+    }
+
+    return true;
+}
+
+void free_json(Json *json)
+{
+    if (json->arena.base) release_scratch_arena(&json->arena);
+    memset(json, 0, sizeof(Json));
+}
+
+b32 json_equals(Json *json, u32 token, const char *string)
+{
+    if (token == JSON_NONE) return false;
+
+    JsonToken *t = &json->tokens[token];
+    usize length = strlen(string);
+    return t->end - t->start == length && memcmp(json->text + t->start, string, length) == 0;
+}
+
+u32 json_find(Json *json, u32 object, const char *key)
+{
+    if (object == JSON_NONE || json->tokens[object].type != JSON_OBJECT) return JSON_NONE;
+
+    // members are a key token and then the value with its children
+    u32 token = object + 1;
+    for (u32 i = 0; i < json->tokens[object].count; i++) {
+        u32 value = token + 1;
+        if (json_equals(json, token, key)) return value;
+        token = json->tokens[value].next;
+    }
+
+    return JSON_NONE;
+}
+
+u32 json_index(Json *json, u32 array, u32 index)
+{
+    if (array == JSON_NONE || json->tokens[array].type != JSON_ARRAY || index >= json->tokens[array].count) return JSON_NONE;
+
+    return json->elements[json->tokens[array].elements + index];
+}
+
+f64 json_number(Json *json, u32 token, f64 default_value)
+{
+    if (token == JSON_NONE || json->tokens[token].type != JSON_PRIMITIVE) return default_value;
+
+    // a primitive always ends before a delimiter inside the root, so strtod stops in time
+    char *start = json->text + json->tokens[token].start;
+    char *end;
+    f64 value = strtod(start, &end);
+
+    return (end == start) ? default_value : value;
+}
+
+f64 json_find_number(Json *json, u32 object, const char *key, f64 default_value)
+{
+    return json_number(json, json_find(json, object, key), default_value);
+}
@@ -0,0 +1,50 @@
+#ifndef JSON_H
+#define JSON_H
+
+// Tokens point into the text, nothing is unescaped or converted until it's asked for.
+// Tokens are stored depth first, a value's children follow it and next skips past them.
+
+#define JSON_NONE 0xffffffff
+#define JSON_MAX_DEPTH 64
+
+typedef enum JsonType {
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_PRIMITIVE // numbers, true, false and null
+} JsonType;
+
+typedef struct JsonToken {
+    JsonType type;
+    u32 start, end; // strings without their quotes
+    u32 count;      // members of an object or elements of an array
+    u32 next;       // the token after this one and everything in it
+    u32 elements;   // where an array's element tokens start in Json.elements
+} JsonToken;
+
+typedef struct Json {
+    char *text;
+    JsonToken *tokens;
+    u32 num_tokens;
+
+    // every array's element tokens in order, so indexing doesn't walk them
+    u32 *elements;
+
+    MemoryArena arena; // scratch the tokens grow in
+} Json;
+
+// The root value is token 0. Returns false and frees everything on malformed text.
+b32 parse_json(Json *json, char *text, u32 length);
+void free_json(Json *json);
+
+// Both return JSON_NONE when the token isn't an object or array or has no such member.
+u32 json_find(Json *json, u32 object, const char *key);
+u32 json_index(Json *json, u32 array, u32 index);
+
+b32 json_equals(Json *json, u32 token, const char *string);
+f64 json_number(Json *json, u32 token, f64 default_value);
+
+// the number member of object, default_value when it is missing
+f64 json_find_number(Json *json, u32 object, const char *key, f64 default_value);
+
+#endif /* JSON_H */
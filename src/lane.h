@@ -0,0 +1,95 @@
+#ifndef LANE_H
+#define LANE_H
+
+// Wide floats for the batch kernels, each lane is a different object. Eight lanes with
+// AVX2 (build.bat's avx2 option), four with SSE and one plain f32 when USE_SIMD_MATHS is
+// 0, which makes the scalar version of every kernel for free.
+//
+// Arrays the kernels walk are padded to a whole number of lanes, see lane_count.
+
+#if !USE_SIMD_MATHS
+
+#define LANE_WIDTH 1
+typedef f32 lane_f32;
+typedef b32 lane_mask;
+
+inline lane_f32 lane_set1(f32 f) { return f; }
+inline lane_f32 lane_load(f32 *memory) { return *memory; }
+inline void lane_store(f32 *memory, lane_f32 a) { *memory = a; }
+
+inline lane_f32 lane_add(lane_f32 a, lane_f32 b) { return a + b; }
+inline lane_f32 lane_sub(lane_f32 a, lane_f32 b) { return a - b; }
+inline lane_f32 lane_mul(lane_f32 a, lane_f32 b) { return a * b; }
+inline lane_f32 lane_div(lane_f32 a, lane_f32 b) { return a / b; }
+inline lane_f32 lane_mul_add(lane_f32 a, lane_f32 b, lane_f32 c) { return a * b + c; }
+inline lane_f32 lane_abs(lane_f32 a) { return fabsf(a); }
+inline lane_f32 lane_round(lane_f32 a) { return floorf(a + 0.5f); }
+inline lane_f32 lane_rsqrt_estimate(lane_f32 a) { return 1.0f / sqrtf(a); }
+
+inline lane_mask lane_less(lane_f32 a, lane_f32 b) { return a < b; }
+inline lane_mask lane_greater(lane_f32 a, lane_f32 b) { return a > b; }
+inline lane_f32 lane_select(lane_mask mask, lane_f32 a, lane_f32 b) { return mask ? a : b; }
+inline lane_mask lane_mask_or(lane_mask a, lane_mask b) { return a || b; }
+inline u32 lane_mask_bits(lane_mask mask) { return mask ? 1 : 0; }
+
+#elif defined(__AVX2__)
+
+#define LANE_WIDTH 8
+typedef __m256 lane_f32;
+typedef __m256 lane_mask;
+
+inline lane_f32 lane_set1(f32 f) { return _mm256_set1_ps(f); }
+inline lane_f32 lane_load(f32 *memory) { return _mm256_loadu_ps(memory); }
+inline void lane_store(f32 *memory, lane_f32 a) { _mm256_storeu_ps(memory, a); }
+
+inline lane_f32 lane_add(lane_f32 a, lane_f32 b) { return _mm256_add_ps(a, b); }
+inline lane_f32 lane_sub(lane_f32 a, lane_f32 b) { return _mm256_sub_ps(a, b); }
+inline lane_f32 lane_mul(lane_f32 a, lane_f32 b) { return _mm256_mul_ps(a, b); }
+inline lane_f32 lane_div(lane_f32 a, lane_f32 b) { return _mm256_div_ps(a, b); }
+// MSVC never defines __FMA__, but every AVX2 part has FMA and /arch:AVX2 allows it
+inline lane_f32 lane_mul_add(lane_f32 a, lane_f32 b, lane_f32 c) { return _mm256_fmadd_ps(a, b, c); }
+inline lane_f32 lane_abs(lane_f32 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+// to nearest, through an integer so |a| has to be under 2^31
+inline lane_f32 lane_round(lane_f32 a) { return _mm256_cvtepi32_ps(_mm256_cvtps_epi32(a)); }
+// about 12 bits
+inline lane_f32 lane_rsqrt_estimate(lane_f32 a) { return _mm256_rsqrt_ps(a); }
+
+inline lane_mask lane_less(lane_f32 a, lane_f32 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline lane_mask lane_greater(lane_f32 a, lane_f32 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline lane_f32 lane_select(lane_mask mask, lane_f32 a, lane_f32 b) { return _mm256_blendv_ps(b, a, mask); }
+inline lane_mask lane_mask_or(lane_mask a, lane_mask b) { return _mm256_or_ps(a, b); }
+// bit n is the mask of lane n
+inline u32 lane_mask_bits(lane_mask mask) { return (u32)_mm256_movemask_ps(mask); }
+
+#else
+
+#define LANE_WIDTH 4
+typedef __m128 lane_f32;
+typedef __m128 lane_mask;
+
+inline lane_f32 lane_set1(f32 f) { return _mm_set1_ps(f); }
+inline lane_f32 lane_load(f32 *memory) { return _mm_loadu_ps(memory); }
+inline void lane_store(f32 *memory, lane_f32 a) { _mm_storeu_ps(memory, a); }
+
+inline lane_f32 lane_add(lane_f32 a, lane_f32 b) { return _mm_add_ps(a, b); }
+inline lane_f32 lane_sub(lane_f32 a, lane_f32 b) { return _mm_sub_ps(a, b); }
+inline lane_f32 lane_mul(lane_f32 a, lane_f32 b) { return _mm_mul_ps(a, b); }
+inline lane_f32 lane_div(lane_f32 a, lane_f32 b) { return _mm_div_ps(a, b); }
+inline lane_f32 lane_mul_add(lane_f32 a, lane_f32 b, lane_f32 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+inline lane_f32 lane_abs(lane_f32 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline lane_f32 lane_round(lane_f32 a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+inline lane_f32 lane_rsqrt_estimate(lane_f32 a) { return _mm_rsqrt_ps(a); }
+
+inline lane_mask lane_less(lane_f32 a, lane_f32 b) { return _mm_cmplt_ps(a, b); }
+inline lane_mask lane_greater(lane_f32 a, lane_f32 b) { return _mm_cmpgt_ps(a, b); }
+// SSE2 has no blend
+inline lane_f32 lane_select(lane_mask mask, lane_f32 a, lane_f32 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+inline lane_mask lane_mask_or(lane_mask a, lane_mask b) { return _mm_or_ps(a, b); }
+inline u32 lane_mask_bits(lane_mask mask) { return (u32)_mm_movemask_ps(mask); }
+
+#endif
+
+// count rounded up to whole lanes
+inline u32 lane_count(u32 count) { return (count + LANE_WIDTH - 1) & ~(LANE_WIDTH - 1); }
+
+#endif /* LANE_H */
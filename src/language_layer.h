@@ -7,9 +7,6 @@
 #include <string.h>
 #include <assert.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb/stb_image.h"
-
 typedef uint8_t   u8;
 typedef uint16_t u16;
 typedef uint32_t u32;
@@ -29,13 +26,33 @@ typedef s32 b32;
 #define true 1
 #define false 0
 
-#define kilobytes(value) ((value)*1024)
+#define kilobytes(value) ((u64)(value)*1024)
 #define megabytes(value) (kilobytes(value)*1024)
 #define gigabytes(value) (megabytes(value)*1024)
 
+#define array_count(array) (sizeof(array) / sizeof((array)[0]))
+
+// Set by build.bat's debug mode, for checks too slow to leave in a release build.
+#ifndef EPSILON_DEBUG
+#define EPSILON_DEBUG 0
+#endif
+
+#include "allocator.h"
+
+// decoded images are counted with everything else
+#define STBI_MALLOC(size) allocate(MEMORY_TAG_IMAGE, size)
+#define STBI_REALLOC(memory, size) reallocate(MEMORY_TAG_IMAGE, memory, size)
+#define STBI_FREE(memory) deallocate(memory)
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+
 #include "maths.h"
+#include "lane.h"
+#include "fast_maths.h"
 #include "utils.h"
+#include "allocator.c"
 #include "maths.c"
+#include "fast_maths.c"
 #include "utils.c"
 
 #endif /* LANGUAGE_LAYER_H */
@@ -13,6 +13,45 @@ inline Matrix3x3 mat3(Matrix4x4 m)
     return result;
 }
 
+inline Matrix3x3 mat3_transpose(Matrix3x3 m)
+{
+    Matrix3x3 result;
+
+    for (u32 i = 0; i < 3; i++) {
+        for (u32 j = 0; j < 3; j++) {
+            result.elements[i][j] = m.elements[j][i];
+        }
+    }
+
+    return result;
+}
+
+// the cofactors over the determinant, transposed
+inline Matrix3x3 mat3_inverse(Matrix3x3 m)
+{
+    Vector3 c0 = vec3(m.elements[0][0], m.elements[0][1], m.elements[0][2]);
+    Vector3 c1 = vec3(m.elements[1][0], m.elements[1][1], m.elements[1][2]);
+    Vector3 c2 = vec3(m.elements[2][0], m.elements[2][1], m.elements[2][2]);
+
+    // the rows of the inverse are perpendicular to two columns each
+    Vector3 r0 = vec3_cross(c1, c2);
+    Vector3 r1 = vec3_cross(c2, c0);
+    Vector3 r2 = vec3_cross(c0, c1);
+
+    f32 determinant = vec3_dot(c0, r0);
+    assert(determinant != 0.0f);
+    f32 inverse_determinant = 1.0f / determinant;
+
+    Matrix3x3 result;
+    for (u32 i = 0; i < 3; i++) {
+        result.elements[i][0] = r0.elements[i] * inverse_determinant;
+        result.elements[i][1] = r1.elements[i] * inverse_determinant;
+        result.elements[i][2] = r2.elements[i] * inverse_determinant;
+    }
+
+    return result;
+}
+
 inline Matrix4x4 mat4(f32 f)
 {
     Matrix4x4 result = { 0 };
@@ -38,7 +77,7 @@ inline Matrix4x4 mat4_from_mat3(Matrix3x3 m)
     return result;
 }
 
-inline Matrix4x4 mat4_mul(Matrix4x4 a, Matrix4x4 b)
+inline Matrix4x4 mat4_mul_scalar(Matrix4x4 a, Matrix4x4 b)
 {
     Matrix4x4 result = { 0 };
 
@@ -54,7 +93,25 @@ inline Matrix4x4 mat4_mul(Matrix4x4 a, Matrix4x4 b)
     return result;
 }
 
-inline Matrix4x4 mat4_mul_float(Matrix4x4 m, f32 f)
+inline Matrix4x4 mat4_mul(Matrix4x4 a, Matrix4x4 b)
+{
+    if (!USE_SIMD_MATHS) return mat4_mul_scalar(a, b);
+
+    Matrix4x4 result;
+
+    // every column of the result is the columns of a weighted by a column of b
+    for (s32 i = 0; i < 4; ++i) {
+        __m128 column = _mm_mul_ps(a.columns[0], _mm_set1_ps(b.elements[i][0]));
+        column = _mm_add_ps(column, _mm_mul_ps(a.columns[1], _mm_set1_ps(b.elements[i][1])));
+        column = _mm_add_ps(column, _mm_mul_ps(a.columns[2], _mm_set1_ps(b.elements[i][2])));
+        column = _mm_add_ps(column, _mm_mul_ps(a.columns[3], _mm_set1_ps(b.elements[i][3])));
+        result.columns[i] = column;
+    }
+
+    return result;
+}
+
+inline Matrix4x4 mat4_mul_float_scalar(Matrix4x4 m, f32 f)
 {
     for (s32 j = 0; j < 4; ++j) {
         for (s32 i = 0; i < 4; ++i) {
@@ -64,6 +121,16 @@ inline Matrix4x4 mat4_mul_float(Matrix4x4 m, f32 f)
     return m;
 }
 
+inline Matrix4x4 mat4_mul_float(Matrix4x4 m, f32 f)
+{
+    if (!USE_SIMD_MATHS) return mat4_mul_float_scalar(m, f);
+
+    __m128 scale = _mm_set1_ps(f);
+    for (s32 i = 0; i < 4; ++i)
+        m.columns[i] = _mm_mul_ps(m.columns[i], scale);
+    return m;
+}
+
 inline Matrix4x4 mat4_ortho(f32 left, f32 right, f32 bottom, f32 top, f32 near_z, f32 far_z)
 {
     Matrix4x4 result = mat4(0.0f);
@@ -170,7 +237,156 @@ inline Matrix4x4 mat4_lookat(Vector3 eye, Vector3 centre, Vector3 up)
     return result;
 }
 
-inline Quaternion quat_mul(Quaternion a, Quaternion b)
+inline Matrix4x4 mat4_inverse_affine(Matrix4x4 m)
+{
+    Matrix3x3 inverse = mat3_inverse(mat3(m));
+    Matrix4x4 result = mat4_from_mat3(inverse);
+
+    // the translation undone after the rest
+    for (u32 j = 0; j < 3; j++) {
+        result.elements[3][j] = -(inverse.elements[0][j] * m.elements[3][0] +
+            inverse.elements[1][j] * m.elements[3][1] +
+            inverse.elements[2][j] * m.elements[3][2]);
+    }
+
+    return result;
+}
+
+// Laplace expansion along the first two and last two columns, the 2x2 determinants are
+// shared between the cofactors
+inline Matrix4x4 mat4_inverse(Matrix4x4 m)
+{
+    f32 *a = m.item;
+
+    f32 s0 = a[0] * a[5] - a[4] * a[1];
+    f32 s1 = a[0] * a[6] - a[4] * a[2];
+    f32 s2 = a[0] * a[7] - a[4] * a[3];
+    f32 s3 = a[1] * a[6] - a[5] * a[2];
+    f32 s4 = a[1] * a[7] - a[5] * a[3];
+    f32 s5 = a[2] * a[7] - a[6] * a[3];
+
+    f32 c5 = a[10] * a[15] - a[14] * a[11];
+    f32 c4 = a[9] * a[15] - a[13] * a[11];
+    f32 c3 = a[9] * a[14] - a[13] * a[10];
+    f32 c2 = a[8] * a[15] - a[12] * a[11];
+    f32 c1 = a[8] * a[14] - a[12] * a[10];
+    f32 c0 = a[8] * a[13] - a[12] * a[9];
+
+    f32 determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    assert(determinant != 0.0f);
+    f32 d = 1.0f / determinant;
+
+    Matrix4x4 result;
+    f32 *r = result.item;
+
+    r[0] = (a[5] * c5 - a[6] * c4 + a[7] * c3) * d;
+    r[1] = (-a[1] * c5 + a[2] * c4 - a[3] * c3) * d;
+    r[2] = (a[13] * s5 - a[14] * s4 + a[15] * s3) * d;
+    r[3] = (-a[9] * s5 + a[10] * s4 - a[11] * s3) * d;
+
+    r[4] = (-a[4] * c5 + a[6] * c2 - a[7] * c1) * d;
+    r[5] = (a[0] * c5 - a[2] * c2 + a[3] * c1) * d;
+    r[6] = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * d;
+    r[7] = (a[8] * s5 - a[10] * s2 + a[11] * s1) * d;
+
+    r[8] = (a[4] * c4 - a[5] * c2 + a[7] * c0) * d;
+    r[9] = (-a[0] * c4 + a[1] * c2 - a[3] * c0) * d;
+    r[10] = (a[12] * s4 - a[13] * s2 + a[15] * s0) * d;
+    r[11] = (-a[8] * s4 + a[9] * s2 - a[11] * s0) * d;
+
+    r[12] = (-a[4] * c3 + a[5] * c1 - a[6] * c0) * d;
+    r[13] = (a[0] * c3 - a[1] * c1 + a[2] * c0) * d;
+    r[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * d;
+    r[15] = (a[8] * s3 - a[9] * s1 + a[10] * s0) * d;
+
+    return result;
+}
+
+inline Matrix3x3 mat4_normal_matrix(Matrix4x4 m)
+{
+    return mat3_transpose(mat3_inverse(mat3(m)));
+}
+
+inline Vector4 mat4_mul_vec4_scalar(Matrix4x4 m, Vector4 v)
+{
+    Vector4 result;
+
+    for (s32 j = 0; j < 4; ++j) {
+        result.elements[j] = (m.elements[0][j] * v.x +
+            m.elements[1][j] * v.y +
+            m.elements[2][j] * v.z +
+            m.elements[3][j] * v.w);
+    }
+
+    return result;
+}
+
+inline Vector4 mat4_mul_vec4(Matrix4x4 m, Vector4 v)
+{
+    if (!USE_SIMD_MATHS) return mat4_mul_vec4_scalar(m, v);
+
+    __m128 column = _mm_mul_ps(m.columns[0], _mm_set1_ps(v.x));
+    column = _mm_add_ps(column, _mm_mul_ps(m.columns[1], _mm_set1_ps(v.y)));
+    column = _mm_add_ps(column, _mm_mul_ps(m.columns[2], _mm_set1_ps(v.z)));
+    column = _mm_add_ps(column, _mm_mul_ps(m.columns[3], _mm_set1_ps(v.w)));
+
+    Vector4 result;
+    _mm_storeu_ps(result.elements, column);
+    return result;
+}
+
+// Gribb/Hartmann, the planes come out in whatever space m transforms from
+// so a model view projection matrix gives a model space frustum
+inline Frustum frustum_from_mat4(Matrix4x4 m)
+{
+    Frustum result;
+
+    for (s32 i = 0; i < 3; ++i) {
+        for (s32 j = 0; j < 4; ++j) {
+            result.planes[i * 2 + 0].elements[j] = m.elements[j][3] + m.elements[j][i];
+            result.planes[i * 2 + 1].elements[j] = m.elements[j][3] - m.elements[j][i];
+        }
+    }
+
+    for (s32 i = 0; i < 6; ++i) {
+        Vector4 plane = result.planes[i];
+        f32 scale = fast_rsqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        result.planes[i] = vec4(plane.x * scale, plane.y * scale, plane.z * scale, plane.w * scale);
+    }
+
+    return result;
+}
+
+inline b32 frustum_contains_sphere(Frustum *frustum, Sphere sphere)
+{
+    for (s32 i = 0; i < 6; ++i) {
+        Vector4 plane = frustum->planes[i];
+        f32 distance = plane.x * sphere.centre.x + plane.y * sphere.centre.y + plane.z * sphere.centre.z + plane.w;
+        if (distance < -sphere.radius)
+            return false;
+    }
+
+    return true;
+}
+
+// conservative, a box near a frustum corner can pass without being inside
+inline b32 frustum_contains_aabb(Frustum *frustum, AABB box)
+{
+    for (s32 i = 0; i < 6; ++i) {
+        Vector4 plane = frustum->planes[i];
+
+        // the corner furthest along the plane normal
+        f32 x = (plane.x >= 0.0f) ? box.max.x : box.min.x;
+        f32 y = (plane.y >= 0.0f) ? box.max.y : box.min.y;
+        f32 z = (plane.z >= 0.0f) ? box.max.z : box.min.z;
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+inline Quaternion quat_mul_scalar(Quaternion a, Quaternion b)
 {
     Quaternion result;
 
@@ -182,12 +398,58 @@ inline Quaternion quat_mul(Quaternion a, Quaternion b)
     return result;
 }
 
-inline Vector3 quat_mul_vec3(Quaternion q, Vector3 v)
+inline Quaternion quat_mul(Quaternion a, Quaternion b)
+{
+    if (!USE_SIMD_MATHS) return quat_mul_scalar(a, b);
+
+    // a.w * b plus a.x, a.y and a.z times b shuffled and with the signs of the products above
+    __m128 result = _mm_mul_ps(_mm_set1_ps(a.w), b.simd);
+
+    __m128 term = _mm_mul_ps(_mm_set1_ps(a.x), _mm_shuffle_ps(b.simd, b.simd, _MM_SHUFFLE(0, 1, 2, 3))); // w z y x
+    result = _mm_add_ps(result, _mm_xor_ps(term, _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f)));
+
+    term = _mm_mul_ps(_mm_set1_ps(a.y), _mm_shuffle_ps(b.simd, b.simd, _MM_SHUFFLE(1, 0, 3, 2))); // z w x y
+    result = _mm_add_ps(result, _mm_xor_ps(term, _mm_set_ps(-0.0f, -0.0f, 0.0f, 0.0f)));
+
+    term = _mm_mul_ps(_mm_set1_ps(a.z), _mm_shuffle_ps(b.simd, b.simd, _MM_SHUFFLE(2, 3, 0, 1))); // y x w z
+    result = _mm_add_ps(result, _mm_xor_ps(term, _mm_set_ps(-0.0f, 0.0f, 0.0f, -0.0f)));
+
+    Quaternion q;
+    q.simd = result;
+    return q;
+}
+
+inline Vector3 quat_mul_vec3_scalar(Quaternion q, Vector3 v)
 {
     Vector3 t = vec3_mul_float(vec3_cross(vec3(q.x, q.y, q.z), v), 2.0f);
     return vec3_add(vec3_add(v, vec3_mul_float(t, q.w)), vec3_cross(vec3(q.x, q.y, q.z), t));
 }
 
+// a.yzx * b.zxy - a.zxy * b.yzx, w stays whatever it was times zero
+inline __m128 cross_sse(__m128 a, __m128 b)
+{
+    __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+    return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+inline Vector3 quat_mul_vec3(Quaternion q, Vector3 v)
+{
+    if (!USE_SIMD_MATHS) return quat_mul_vec3_scalar(q, v);
+
+    __m128 u = _mm_and_ps(q.simd, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+    __m128 p = _mm_set_ps(0.0f, v.z, v.y, v.x);
+
+    __m128 t = cross_sse(u, p);
+    t = _mm_add_ps(t, t);
+    __m128 result = _mm_add_ps(_mm_add_ps(p, _mm_mul_ps(t, _mm_set1_ps(q.w))), cross_sse(u, t));
+
+    f32 out[4];
+    _mm_storeu_ps(out, result);
+    return vec3(out[0], out[1], out[2]);
+}
+
 inline Quaternion quat_conjugate(Quaternion q)
 {
     Quaternion result;
@@ -2,6 +2,12 @@
 #define MATHS_H
 
 #include <math.h>
+#include <float.h>
+#include <immintrin.h>
+
+// SSE versions of the matrix and quaternion ops that run per object per frame. 0 uses the
+// scalar versions everywhere, they're kept to check the SIMD ones against either way.
+#define USE_SIMD_MATHS 1
 
 #define PI 3.1415926535897f
 
@@ -47,6 +53,9 @@ inline Vector3 vec3_cross(Vector3 a, Vector3 b) {
         a.x * b.y - a.y * b.x);
 }
 
+inline Vector3 vec3_min(Vector3 a, Vector3 b) { return vec3(fminf(a.x, b.x), fminf(a.y, b.y), fminf(a.z, b.z)); }
+inline Vector3 vec3_max(Vector3 a, Vector3 b) { return vec3(fmaxf(a.x, b.x), fmaxf(a.y, b.y), fmaxf(a.z, b.z)); }
+
 typedef union Vector4 {
     struct { f32 x, y, z, w; };
     struct { f32 r, g, b, a; };
@@ -60,23 +69,49 @@ inline Vector4 vec4_sub(Vector4 a, Vector4 b) { return vec4(a.x - b.x, a.y - b.y
 inline Vector4 vec4_mul(Vector4 a, Vector4 b) { return vec4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w); }
 inline Vector4 vec4_div(Vector4 a, Vector4 b) { return vec4(a.x / b.x, a.y / b.y, a.z / b.z, a.w / b.w); }
 
+typedef struct AABB {
+    Vector3 min;
+    Vector3 max;
+} AABB;
+
+inline AABB aabb_empty(void) { return (AABB){ vec3(FLT_MAX, FLT_MAX, FLT_MAX), vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX) }; }
+inline AABB aabb_add_point(AABB box, Vector3 p) { return (AABB){ vec3_min(box.min, p), vec3_max(box.max, p) }; }
+inline Vector3 aabb_centre(AABB box) { return vec3_mul_float(vec3_add(box.min, box.max), 0.5f); }
+inline Vector3 aabb_extents(AABB box) { return vec3_mul_float(vec3_sub(box.max, box.min), 0.5f); }
+
+typedef struct Sphere {
+    Vector3 centre;
+    f32 radius;
+} Sphere;
+
+// planes face inwards, xyz is the normal and w the distance
+typedef struct Frustum {
+    Vector4 planes[6];
+} Frustum;
+
 typedef union Matrix3x3 {
     f32 elements[3][3];
     f32 item[9];
 } Matrix3x3;
 
+// column major, elements[column][row], the columns keep it 16 byte aligned
 typedef union Matrix4x4 {
     f32 elements[4][4];
     f32 item[16];
+    __m128 columns[4];
 } Matrix4x4;
 
 inline Matrix3x3 mat3(Matrix4x4 m);
+inline Matrix3x3 mat3_transpose(Matrix3x3 m);
+inline Matrix3x3 mat3_inverse(Matrix3x3 m);
 
 inline Matrix4x4 mat4(f32 f);
 inline Matrix4x4 mat4_from_mat3(Matrix3x3 m);
 
 inline Matrix4x4 mat4_mul(Matrix4x4 a, Matrix4x4 b);
 inline Matrix4x4 mat4_mul_float(Matrix4x4 m, f32 f);
+inline Matrix4x4 mat4_mul_scalar(Matrix4x4 a, Matrix4x4 b);
+inline Matrix4x4 mat4_mul_float_scalar(Matrix4x4 m, f32 f);
 
 inline Matrix4x4 mat4_ortho(f32 left, f32 right, f32 bottom, f32 top, f32 near_z, f32 far_z);
 inline Matrix4x4 mat4_perspective(f32 fov, f32 aspect_ratio, f32 near_z, f32 far_z);
@@ -87,17 +122,34 @@ inline Matrix4x4 mat4_scale(Vector3 scale);
 
 inline Matrix4x4 mat4_lookat(Vector3 eye, Vector3 centre, Vector3 up);
 
+// For rotations, scales, shears and translations, cheaper than mat4_inverse since the
+// last row is known to be 0 0 0 1.
+inline Matrix4x4 mat4_inverse_affine(Matrix4x4 m);
+inline Matrix4x4 mat4_inverse(Matrix4x4 m);
+// transpose(inverse(mat3(m))), what normals go through when positions go through m
+inline Matrix3x3 mat4_normal_matrix(Matrix4x4 m);
+
+inline Vector4 mat4_mul_vec4(Matrix4x4 m, Vector4 v);
+inline Vector4 mat4_mul_vec4_scalar(Matrix4x4 m, Vector4 v);
+
+inline Frustum frustum_from_mat4(Matrix4x4 m);
+inline b32 frustum_contains_sphere(Frustum *frustum, Sphere sphere);
+inline b32 frustum_contains_aabb(Frustum *frustum, AABB box);
+
 typedef union Quaternion {
     struct {
         struct { f32 x, y, z; };
         f32 w;
     };
     f32 elements[4];
+    __m128 simd;
 } Quaternion;
 
 inline Quaternion quat_mul(Quaternion a, Quaternion b);
+inline Quaternion quat_mul_scalar(Quaternion a, Quaternion b);
 inline Quaternion quat_mul_float(Quaternion q, f32 f) { return (Quaternion){ q.x * f, q.y * f, q.z * f, q.w * f}; }
 inline Vector3 quat_mul_vec3(Quaternion q, Vector3 v);
+inline Vector3 quat_mul_vec3_scalar(Quaternion q, Vector3 v);
 
 inline f32 quat_length_sq(Quaternion q) { return (q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w); }
 inline f32 quat_length(Quaternion q) { return (f32)sqrt(quat_length_sq(q)); }
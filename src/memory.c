@@ -1,16 +1,261 @@
 #include "memory.h"
 
-void alloc_arena(MemoryArena *arena, usize size, u64 *base)
+// This thread's arena in global_thread_scratches, found once per load of the game code.
+static __declspec(thread) MemoryArena *global_thread_scratch;
+
+inline usize align_up(usize value, usize alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Commits on scratch reservations count as loader memory until the reservation goes.
+static void track_scratch_commit(s64 volatile *tracked, usize size)
+{
+    if (!tracked) return;
+
+    InterlockedExchangeAdd64((LONG64 volatile *)tracked, (LONG64)size);
+    track_memory_growth(MEMORY_TAG_MESH_BUILD, (s64)size, 0);
+}
+
+inline void check_arena_thread(MemoryArena *arena)
+{
+    if (!CHECK_ARENA_THREADS) return;
+
+    u32 thread = (u32)GetCurrentThreadId();
+    if (!arena->owner_thread) arena->owner_thread = thread;
+    assert(arena->owner_thread == thread); // pushed on from two threads without a reset between
+}
+
+void alloc_arena(MemoryArena *arena, usize size, void *base)
 {
     arena->size = size;
-    arena->base = base;
+    arena->base = (u8 *)base;
+    arena->used = 0;
+    arena->committed = size;
+    arena->commit = NULL;
+    arena->temporary_count = 0;
+    arena->owner_thread = 0;
+    arena->tracked = NULL;
+    arena->tracked_size = 0;
+}
+
+void reserve_arena(MemoryArena *arena, usize size, void *base, b32 (*commit)(void *memory, usize size))
+{
+    alloc_arena(arena, size, base);
+    arena->committed = 0;
+    arena->commit = commit;
+}
+
+void reset_arena(MemoryArena *arena)
+{
+    // committed pages stay committed, the next frame or load will want them again
+    assert(arena->temporary_count == 0);
     arena->used = 0;
+    arena->owner_thread = 0;
+}
+
+static void *push_memory_internal(MemoryArena *arena, usize size, usize alignment, b32 commit)
+{
+    assert(alignment && (alignment & (alignment - 1)) == 0);
+    check_arena_thread(arena);
+
+    usize address = (usize)(arena->base + arena->used);
+    usize padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+    usize end = arena->used + padding + size;
+    assert(end <= arena->size);
+
+    if (commit && end > arena->committed) {
+        usize committed = align_up(end, ARENA_COMMIT_SIZE);
+        if (committed > arena->size) committed = arena->size;
+
+        b32 success = arena->commit(arena->base + arena->committed, committed - arena->committed);
+        assert(success);
+        track_scratch_commit(arena->tracked, committed - arena->committed);
+        arena->committed = committed;
+    }
+
+    void *result = arena->base + arena->used + padding;
+    arena->used = end;
+    return result;
+}
+
+void *push_memory_aligned(MemoryArena *arena, usize size, usize alignment)
+{
+    return push_memory_internal(arena, size, alignment, true);
 }
 
 void *push_memory(MemoryArena *arena, usize size)
 {
-    assert((arena->used + size) <= arena->size);
-    void *result = arena->base + arena->used;
-    arena->used += size;
+    return push_memory_internal(arena, size, DEFAULT_ALIGNMENT, true);
+}
+
+void sub_arena(MemoryArena *result, MemoryArena *arena, usize size)
+{
+    if (!arena->commit) {
+        alloc_arena(result, size, push_memory(arena, size));
+        return;
+    }
+
+    // whole commit steps so the parent and child never share one, the parent carries on
+    // committing past the child and the child commits its own range as it grows
+    u8 *base = (u8 *)push_memory_internal(arena, align_up(size, ARENA_COMMIT_SIZE), ARENA_COMMIT_SIZE, false);
+    if (arena->committed < arena->used) arena->committed = arena->used;
+    reserve_arena(result, size, base, arena->commit);
+    result->tracked = arena->tracked;
+}
+
+MemoryArena *get_thread_scratch(void)
+{
+    MemoryArena *scratch = global_thread_scratch;
+    if (scratch) return scratch;
+
+    ThreadScratches *scratches = global_thread_scratches;
+    assert(scratches != NULL);
+    u32 thread = (u32)GetCurrentThreadId();
+
+    // the slot this thread had before a reload, otherwise the first free one
+    u32 slot = 0;
+    while (slot < MAX_SCRATCH_THREADS && scratches->threads[slot] != thread) slot++;
+    if (slot == MAX_SCRATCH_THREADS) {
+        for (slot = 0; slot < MAX_SCRATCH_THREADS; slot++) {
+            if (InterlockedCompareExchange((LONG volatile *)&scratches->threads[slot], (LONG)thread, 0) == 0) break;
+        }
+        assert(slot < MAX_SCRATCH_THREADS);
+    }
+
+    scratch = &scratches->arenas[slot];
+    if (!scratch->base) reserve_scratch_arena(scratch, THREAD_SCRATCH_SIZE);
+    global_thread_scratch = scratch;
+    return scratch;
+}
+
+void release_thread_scratches(void)
+{
+    ThreadScratches *scratches = global_thread_scratches;
+    if (!scratches) return;
+
+    for (u32 slot = 0; slot < MAX_SCRATCH_THREADS; slot++) {
+        if (scratches->arenas[slot].base) release_scratch_arena(&scratches->arenas[slot]);
+        scratches->threads[slot] = 0;
+    }
+}
+
+void sub_atomic_arena(AtomicArena *result, MemoryArena *arena, usize size)
+{
+    MemoryArena child;
+    sub_arena(&child, arena, size);
+
+    result->size = child.size;
+    result->base = child.base;
+    result->used = 0;
+    result->committed = child.committed;
+    result->commit = child.commit;
+    result->tracked = child.tracked;
+}
+
+void reset_atomic_arena(AtomicArena *arena)
+{
+    arena->used = 0;
+}
+
+void *push_memory_atomic(AtomicArena *arena, usize size)
+{
+    // claim the range, a thread that loses the race aligns again from the new top
+    usize used = arena->used;
+    usize start, end;
+    for (;;) {
+        start = align_up((usize)arena->base + used, DEFAULT_ALIGNMENT) - (usize)arena->base;
+        end = start + size;
+        assert(end <= arena->size);
+
+        usize original = (usize)InterlockedCompareExchange64((LONG64 volatile *)&arena->used, (LONG64)end, (LONG64)used);
+        if (original == used) break;
+        used = original;
+    }
+
+    usize committed = arena->committed;
+    if (arena->commit && end > committed) {
+        // committing pages twice is harmless, so a push never waits on another's commit
+        usize from = start & ~(ARENA_COMMIT_SIZE - 1);
+        usize to = align_up(end, ARENA_COMMIT_SIZE);
+        if (to > arena->size) to = arena->size;
+
+        b32 success = arena->commit(arena->base + from, to - from);
+        assert(success);
+        track_scratch_commit(arena->tracked, to - from);
+
+        // only extend committed when this range joins onto it, past a gap it would lie
+        while (committed >= from && committed < to) {
+            usize original = (usize)InterlockedCompareExchange64((LONG64 volatile *)&arena->committed, (LONG64)to, (LONG64)committed);
+            if (original == committed) break;
+            committed = original;
+        }
+    }
+
+    return arena->base + start;
+}
+
+TemporaryMemory begin_temporary_memory(MemoryArena *arena)
+{
+    check_arena_thread(arena);
+
+    TemporaryMemory temporary;
+    temporary.arena = arena;
+    temporary.used = arena->used;
+    arena->temporary_count++;
+
+    return temporary;
+}
+
+void end_temporary_memory(TemporaryMemory temporary)
+{
+    MemoryArena *arena = temporary.arena;
+    assert(arena->used >= temporary.used && arena->temporary_count > 0);
+    check_arena_thread(arena);
+
+    arena->used = temporary.used;
+    arena->temporary_count--;
+}
+
+void reserve_scratch_arena(MemoryArena *arena, usize size)
+{
+    void *base = global_platform->reserve_memory(size);
+    assert(base != NULL);
+    reserve_arena(arena, size, base, global_platform->commit_memory);
+
+    // reservations made before there are stats aren't taken off them either
+    if (global_memory_stats) {
+        arena->tracked = &arena->tracked_size;
+        track_memory_growth(MEMORY_TAG_MESH_BUILD, 0, 1);
+    }
+}
+
+void release_scratch_arena(MemoryArena *arena)
+{
+    assert(arena->temporary_count == 0);
+    if (arena->tracked) track_memory_growth(MEMORY_TAG_MESH_BUILD, -arena->tracked_size, -1);
+    global_platform->release_memory(arena->base, arena->size);
+    memset(arena, 0, sizeof(MemoryArena));
+}
+
+GrowableArray begin_growable_array(MemoryArena *arena, usize item_size)
+{
+    GrowableArray array;
+    array.arena = arena;
+    array.base = (u8 *)push_memory(arena, 0);
+    array.item_size = item_size;
+    array.count = 0;
+
+    return array;
+}
+
+void *grow_array(GrowableArray *array, usize count)
+{
+    // something else pushed on the arena would be overwritten by the new items
+    MemoryArena *arena = array->arena;
+    assert(arena->base + arena->used == array->base + array->count * array->item_size);
+
+    void *result = push_memory_aligned(arena, count * array->item_size, 1);
+    array->count += count;
     return result;
 }
@@ -1,16 +1,126 @@
 #ifndef MEMORY_H
 #define MEMORY_H
 
+// Pushes are aligned to this unless asked otherwise, enough for any SSE type.
+#define DEFAULT_ALIGNMENT 16
+
+// Reserved arenas commit in steps this big, so growing is a system call every so often.
+#define ARENA_COMMIT_SIZE megabytes(1)
+
+// Arenas remember the thread that pushes on them and assert when another one does.
+// Resetting an arena hands it to whichever thread pushes next. Debug builds only, it
+// costs a system call on every push.
+#define CHECK_ARENA_THREADS EPSILON_DEBUG
+
+// Address space of each thread's scratch arena, only what's pushed gets committed.
+#define THREAD_SCRATCH_SIZE gigabytes(4)
+
+// The main thread and every worker the platform starts.
+#define MAX_SCRATCH_THREADS 32
+
 typedef struct MemoryArena {
     usize size;
-    u64 *base;
+    u8 *base;
     usize used;
+
+    // Reserved arenas commit pages as pushes reach them, commit is NULL for memory that's
+    // already committed. The arena commits from committed upwards.
+    usize committed;
+    b32 (*commit)(void *memory, usize size);
+
+    u32 temporary_count; // open begin_temporary_memory scopes
+    u32 owner_thread;    // CHECK_ARENA_THREADS, 0 until something is pushed
+
+    // Scratch reservations count what they commit in the memory stats. Sub arenas share
+    // the reservation's tracked_size through tracked, so release can give it all back.
+    s64 volatile *tracked;
+    s64 volatile tracked_size;
 } MemoryArena;
 
+// Any number of threads can push at once, the bump is a compare exchange so nobody waits.
+// For results many workers share that live on after them. Only resetting needs everyone
+// to have finished pushing.
+typedef struct AtomicArena {
+    usize size;
+    u8 *base;
+    usize volatile used;
+
+    // pushes commit their own pages, committed only covers what's known to be contiguous
+    usize volatile committed;
+    b32 (*commit)(void *memory, usize size);
+    s64 volatile *tracked; // see MemoryArena
+} AtomicArena;
+
+// Every thread's scratch arena by thread id. The threads belong to the platform and outlive
+// the game code, so this lives in the game state and a reload finds their arenas again.
+typedef struct ThreadScratches {
+    u32 volatile threads[MAX_SCRATCH_THREADS]; // 0 for a free slot
+    MemoryArena arenas[MAX_SCRATCH_THREADS];
+} ThreadScratches;
+
+// Where get_thread_scratch finds the table, set with global_memory_stats.
+static ThreadScratches *global_thread_scratches;
+
+// Everything pushed between begin and end is given back at the end. Scopes nest and have
+// to end in the reverse order they began.
+typedef struct TemporaryMemory {
+    MemoryArena *arena;
+    usize used;
+} TemporaryMemory;
+
+// An array growing at the top of an arena, nothing else can be pushed on the arena until
+// it's finished. Reserved arenas commit as it grows so the items never move, which lets
+// loaders build an array in place on the arena it's going to stay on.
+typedef struct GrowableArray {
+    MemoryArena *arena;
+    u8 *base;
+    usize item_size;
+    usize count;
+} GrowableArray;
+
 #define push_struct(arena, type) (type *)push_memory(arena, sizeof(type))
-#define push_array(arena, count, type) (type *)push_memory(arena, count * sizeof(type))
+#define push_array(arena, count, type) (type *)push_memory(arena, (count) * sizeof(type))
+#define push_array_aligned(arena, count, type, alignment) (type *)push_memory_aligned(arena, (count) * sizeof(type), alignment)
+
+void alloc_arena(MemoryArena *arena, usize size, void *base);
+// Over reserved address space, commit is the platform's commit_memory.
+void reserve_arena(MemoryArena *arena, usize size, void *base, b32 (*commit)(void *memory, usize size));
+// A child arena carved out of the parent, it never gives the memory back. Children of
+// reserved arenas commit their own pages as they grow.
+void sub_arena(MemoryArena *result, MemoryArena *arena, usize size);
+void reset_arena(MemoryArena *arena);
+
+// This thread's scratch, reserved the first time it's asked for. Pushes on it belong in a
+// begin/end_temporary_memory scope that ends before the function returns.
+MemoryArena *get_thread_scratch(void);
+// Gives every thread's scratch back, for shutdown once no thread is using its own.
+void release_thread_scratches(void);
 
-void alloc_arena(MemoryArena *arena, usize size, u64 *base);
 void *push_memory(MemoryArena *arena, usize size);
+// alignment is a power of two, it applies to the address not the offset into the arena
+void *push_memory_aligned(MemoryArena *arena, usize size, usize alignment);
+
+TemporaryMemory begin_temporary_memory(MemoryArena *arena);
+void end_temporary_memory(TemporaryMemory temporary);
+
+// An arena over a range of its own for scratch that can't be sized up front. size is only
+// address space, what's pushed is committed and release gives the whole range back. The
+// committed bytes count under MEMORY_TAG_MESH_BUILD, each reservation as one allocation.
+void reserve_scratch_arena(MemoryArena *arena, usize size);
+void release_scratch_arena(MemoryArena *arena);
+
+void sub_atomic_arena(AtomicArena *result, MemoryArena *arena, usize size);
+void reset_atomic_arena(AtomicArena *arena);
+void *push_memory_atomic(AtomicArena *arena, usize size);
+#define push_struct_atomic(arena, type) (type *)push_memory_atomic(arena, sizeof(type))
+#define push_array_atomic(arena, count, type) (type *)push_memory_atomic(arena, (count) * sizeof(type))
+
+#define begin_array(arena, type) begin_growable_array(arena, sizeof(type))
+#define array_add(array, count, type) ((type *)grow_array(array, count))
+#define array_push(array, type, value) (*array_add(array, 1, type) = (value))
+
+GrowableArray begin_growable_array(MemoryArena *arena, usize item_size);
+// Returns the first of count new items, they aren't cleared.
+void *grow_array(GrowableArray *array, usize count);
 
 #endif /* MEMORY_H */
@@ -1,156 +1,1414 @@
 #include "mesh.h"
 
-static void upload_mesh(Mesh *mesh)
+inline u16 quantise_unorm16(f32 value)
+{
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (u16)(value * 65535.0f + 0.5f);
+}
+
+// Projects the unit normal onto an octahedron and folds the lower half over the upper,
+// two 16 bit components are far more than shading needs.
+static void encode_octahedral(Vector3 n, u16 *out)
+{
+    f32 sum = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    if (sum == 0.0f) {
+        n = vec3(0.0f, 0.0f, 1.0f);
+        sum = 1.0f;
+    }
+
+    f32 x = n.x / sum;
+    f32 y = n.y / sum;
+    if (n.z < 0.0f) {
+        f32 folded_x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        f32 folded_y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = folded_x;
+        y = folded_y;
+    }
+
+    out[0] = quantise_unorm16(x * 0.5f + 0.5f);
+    out[1] = quantise_unorm16(y * 0.5f + 0.5f);
+}
+
+// Matches decode_normal in the shaders, the tangent is encoded against what the GPU will see.
+static Vector3 decode_octahedral(u16 *in)
+{
+    f32 x = (f32)in[0] / 65535.0f * 2.0f - 1.0f;
+    f32 y = (f32)in[1] / 65535.0f * 2.0f - 1.0f;
+    Vector3 n = vec3(x, y, 1.0f - fabsf(x) - fabsf(y));
+
+    f32 t = fmaxf(-n.z, 0.0f);
+    n.x += (n.x >= 0.0f) ? -t : t;
+    n.y += (n.y >= 0.0f) ? -t : t;
+
+    return vec3_norm(n);
+}
+
+// Frisvad's basis around n as revised by Duff et al., the shaders build the same one so
+// only the angle of the tangent in it has to be stored. The basis flips between the
+// hemispheres, which one is picked from the integer octahedral code so the CPU and GPU
+// can't land on different sides of the equator.
+static void tangent_basis(u16 *packed_normal, Vector3 *b1, Vector3 *b2)
+{
+    Vector3 n = decode_octahedral(packed_normal);
+    s32 folded = abs(2 * (s32)packed_normal[0] - 65535) + abs(2 * (s32)packed_normal[1] - 65535);
+    f32 s = (folded > 65535) ? -1.0f : 1.0f;
+
+    f32 a = -1.0f / (s + n.z);
+    f32 b = n.x * n.y * a;
+    *b1 = vec3(1.0f + s * n.x * n.x * a, s * b, -s * n.x);
+    *b2 = vec3(b, s + n.y * n.y * a, -n.y);
+}
+
+static u16 encode_tangent(u16 *packed_normal, Vector4 tangent)
+{
+    Vector3 b1, b2;
+    tangent_basis(packed_normal, &b1, &b2);
+
+    Vector3 t = vec3(tangent.x, tangent.y, tangent.z);
+    f32 turns = (f32)atan2(vec3_dot(t, b2), vec3_dot(t, b1)) / (2.0f * PI);
+    if (turns < 0.0f) turns += 1.0f;
+
+    u16 angle = (u16)((u32)(turns * 32768.0f + 0.5f) & 0x7fff);
+    return (u16)(angle | ((tangent.w < 0.0f) ? 0x8000 : 0));
+}
+
+static void pack_vertices(Mesh *mesh, PackedVertex *packed)
+{
+    Vector2 texcoord_min = vec2(FLT_MAX, FLT_MAX);
+    Vector2 texcoord_max = vec2(-FLT_MAX, -FLT_MAX);
+    for (u32 i = 0; i < mesh->num_vertices; i++) {
+        Vector2 texcoord = mesh->vertices[i].texcoord;
+        texcoord_min = vec2(fminf(texcoord_min.x, texcoord.x), fminf(texcoord_min.y, texcoord.y));
+        texcoord_max = vec2(fmaxf(texcoord_max.x, texcoord.x), fmaxf(texcoord_max.y, texcoord.y));
+    }
+
+    // flat axes keep a scale of one so nothing divides by zero
+    Vector3 position_scale = vec3_sub(mesh->bounds.max, mesh->bounds.min);
+    Vector2 texcoord_scale = vec2_sub(texcoord_max, texcoord_min);
+    if (position_scale.x <= 0.0f) position_scale.x = 1.0f;
+    if (position_scale.y <= 0.0f) position_scale.y = 1.0f;
+    if (position_scale.z <= 0.0f) position_scale.z = 1.0f;
+    if (texcoord_scale.x <= 0.0f) texcoord_scale.x = 1.0f;
+    if (texcoord_scale.y <= 0.0f) texcoord_scale.y = 1.0f;
+
+    mesh->position_offset = mesh->bounds.min;
+    mesh->position_scale = position_scale;
+    mesh->texcoord_offset = texcoord_min;
+    mesh->texcoord_scale = texcoord_scale;
+
+    for (u32 i = 0; i < mesh->num_vertices; i++) {
+        Vertex *vertex = &mesh->vertices[i];
+        Vector3 position = vec3_div(vec3_sub(vertex->position, mesh->position_offset), position_scale);
+        Vector2 texcoord = vec2_div(vec2_sub(vertex->texcoord, texcoord_min), texcoord_scale);
+
+        packed[i].position[0] = quantise_unorm16(position.x);
+        packed[i].position[1] = quantise_unorm16(position.y);
+        packed[i].position[2] = quantise_unorm16(position.z);
+        packed[i].texcoord[0] = quantise_unorm16(texcoord.x);
+        packed[i].texcoord[1] = quantise_unorm16(texcoord.y);
+        encode_octahedral(vertex->normal, packed[i].normal);
+        packed[i].position[3] = encode_tangent(packed[i].normal, vertex->tangent);
+    }
+}
+
+// Converts the vertices and indices to what the GL buffers hold, one block with the vertex
+// data first. Only touches the mesh, so streamed meshes do it on the loading thread.
+static MeshUpload prepare_mesh_upload(Mesh *mesh)
+{
+    MeshUpload upload = { 0 };
+
+    // the source's bytes are already what GL wants
+    if (mesh->vertex_format == VERTEX_FORMAT_EXTERNAL) {
+        mesh->position_offset = vec3(0.0f, 0.0f, 0.0f);
+        mesh->position_scale = vec3(1.0f, 1.0f, 1.0f);
+        mesh->texcoord_offset = vec2(0.0f, 0.0f);
+        mesh->texcoord_scale = vec2(1.0f, 1.0f);
+
+        upload.data = mesh->external_data;
+        upload.vertex_size = mesh->external_vertex_size;
+        upload.index_size = mesh->external_index_size;
+        upload.borrowed = true;
+        return upload;
+    }
+
+    upload.vertex_size = mesh->num_vertices * (u32)((mesh->vertex_format == VERTEX_FORMAT_PACKED) ? sizeof(PackedVertex) : sizeof(Vertex));
+    upload.index_size = mesh->num_indices * (u32)((mesh->num_vertices <= 0xffff) ? sizeof(u16) : sizeof(u32));
+    upload.data = (u8 *)allocate(MEMORY_TAG_MESH, upload.vertex_size + upload.index_size);
+
+    if (mesh->vertex_format == VERTEX_FORMAT_PACKED) {
+        pack_vertices(mesh, (PackedVertex *)upload.data);
+    } else {
+        mesh->position_offset = vec3(0.0f, 0.0f, 0.0f);
+        mesh->position_scale = vec3(1.0f, 1.0f, 1.0f);
+        mesh->texcoord_offset = vec2(0.0f, 0.0f);
+        mesh->texcoord_scale = vec2(1.0f, 1.0f);
+        memcpy(upload.data, mesh->vertices, upload.vertex_size);
+    }
+
+    if (mesh->num_vertices <= 0xffff) {
+        u16 *indices = (u16 *)(upload.data + upload.vertex_size);
+        for (u32 i = 0; i < mesh->num_indices; i++)
+            indices[i] = (u16)mesh->indices[i];
+        mesh->index_type = GL_UNSIGNED_SHORT;
+    } else {
+        memcpy(upload.data + upload.vertex_size, mesh->indices, upload.index_size);
+        mesh->index_type = GL_UNSIGNED_INT;
+    }
+
+    if (mesh->baked_file.data) {
+        unmap_file(&mesh->baked_file);
+        mesh->vertices = NULL;
+        mesh->indices = NULL;
+    }
+
+    return upload;
+}
+
+static void free_mesh_upload(MeshUpload *upload)
+{
+    if (!upload->borrowed) deallocate(upload->data);
+    upload->data = NULL;
+}
+
+// Allocates the buffers and sets up the vertex array, the data goes in with upload_mesh_range.
+static void create_mesh_buffers(Mesh *mesh, MeshUpload *upload)
 {
     glGenVertexArrays(1, &mesh->vertex_array);
     glBindVertexArray(mesh->vertex_array);
 
     glGenBuffers(1, &mesh->vertex_buffer);
     glBindBuffer(GL_ARRAY_BUFFER, mesh->vertex_buffer);
-    glBufferData(GL_ARRAY_BUFFER, mesh->num_vertices * sizeof(Vertex), mesh->vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, upload->vertex_size, NULL, GL_STATIC_DRAW);
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+    if (mesh->vertex_format == VERTEX_FORMAT_PACKED) {
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), 0);
 
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(f32)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)(4 * sizeof(u16)));
+
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)(6 * sizeof(u16)));
+    } else if (mesh->vertex_format == VERTEX_FORMAT_EXTERNAL) {
+        GLint sizes[4] = { 3, 2, 3, 4 };
+        for (u32 i = 0; i < array_count(sizes); i++) {
+            glEnableVertexAttribArray(i);
+            glVertexAttribPointer(i, sizes[i], GL_FLOAT, GL_FALSE, mesh->attribute_strides[i], (void *)(usize)mesh->attribute_offsets[i]);
+        }
+    } else {
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
 
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(5 * sizeof(f32)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(f32)));
+
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(5 * sizeof(f32)));
+
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(8 * sizeof(f32)));
+    }
 
     glGenBuffers(1, &mesh->index_buffer);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->index_buffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->num_indices * sizeof(u32), mesh->indices, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, upload->index_size, NULL, GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+
+    mesh->buffer_size = upload->vertex_size + upload->index_size;
+    track_memory(MEMORY_TAG_GL_BUFFER, mesh->buffer_size);
+}
+
+// offset and size are in bytes of the upload's block, a range can span both buffers
+static void upload_mesh_range(Mesh *mesh, MeshUpload *upload, u32 offset, u32 size)
+{
+    if (offset < upload->vertex_size) {
+        u32 vertex_bytes = (size < upload->vertex_size - offset) ? size : upload->vertex_size - offset;
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->vertex_buffer);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, vertex_bytes, upload->data + offset);
+        offset += vertex_bytes;
+        size -= vertex_bytes;
+    }
+
+    if (size) {
+        // the element array binding belongs to the vertex array
+        glBindVertexArray(mesh->vertex_array);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset - upload->vertex_size, size, upload->data + offset);
+        glBindVertexArray(0);
+    }
+}
+
+static void upload_mesh(Mesh *mesh)
+{
+    MeshUpload upload = prepare_mesh_upload(mesh);
+    create_mesh_buffers(mesh, &upload);
+    upload_mesh_range(mesh, &upload, 0, upload.vertex_size + upload.index_size);
+    free_mesh_upload(&upload);
+
+    mesh->resident = true;
+}
+
+// Copies what drawing needs into one heap block the mesh owns and forgets the CPU side
+// vertices and indices, so whatever the loader pushed on its arena can be given back.
+static void keep_mesh_draw_data(Mesh *mesh)
+{
+    // material slots hold u64s, they go first to stay aligned
+    usize slots_size = mesh->num_material_slots * sizeof(MaterialSlot);
+    usize submeshes_size = mesh->num_submeshes * sizeof(Submesh);
+    usize meshlets_size = mesh->num_meshlets * sizeof(Meshlet);
+
+    u8 *data = (u8 *)allocate(MEMORY_TAG_MESH, slots_size + submeshes_size + meshlets_size);
+    memcpy(data, mesh->material_slots, slots_size);
+    memcpy(data + slots_size, mesh->submeshes, submeshes_size);
+    memcpy(data + slots_size + submeshes_size, mesh->meshlets, meshlets_size);
+
+    mesh->material_slots = (MaterialSlot *)data;
+    mesh->submeshes = (Submesh *)(data + slots_size);
+    mesh->meshlets = (Meshlet *)(data + slots_size + submeshes_size);
+    mesh->draw_data = data;
+
+    mesh->vertices = NULL;
+    mesh->indices = NULL;
+    mesh->external_data = NULL;
 }
 
-static char *read_line(FILE *file)
+// Gives back the GL objects and the draw data, the Mesh itself belongs to whoever holds it.
+static void free_mesh(Mesh *mesh)
 {
-    char *line = NULL;
+    glDeleteVertexArrays(1, &mesh->vertex_array);
+    glDeleteBuffers(1, &mesh->vertex_buffer);
+    glDeleteBuffers(1, &mesh->index_buffer);
+    track_memory(MEMORY_TAG_GL_BUFFER, -(s64)mesh->buffer_size);
+    deallocate(mesh->draw_data);
+
+    mesh->vertex_array = mesh->vertex_buffer = mesh->index_buffer = 0;
+    mesh->buffer_size = 0;
+    mesh->draw_data = NULL;
+    mesh->resident = false;
+}
+
+static void draw_mesh_range(Mesh *mesh, u32 index_offset, u32 index_count)
+{
+    usize index_size = (mesh->index_type == GL_UNSIGNED_SHORT) ? sizeof(u16) : sizeof(u32);
+    glDrawElements(GL_TRIANGLES, index_count, mesh->index_type, (void *)(index_offset * index_size));
+}
+
+void draw_mesh_lod(Mesh *mesh, u32 lod)
+{
+    draw_mesh_range(mesh, mesh->lods[lod].index_offset, mesh->lods[lod].index_count);
+}
 
-    while (1) {
-        s32 c = fgetc(file);
-        if (c == EOF) return line;
-        sb_push(line, (char)c);
-        if (c == '\n') {
-            sb_push(line, '\0');
-            return line;
+// texture units 0 to 3, maps the slot's material doesn't have come from the mesh's
+static void bind_material_slot(AssetRegistry *registry, Mesh *mesh, MaterialSlot *slot)
+{
+    // destroyed materials and textures resolve to NULL and fall back like missing ones
+    Material *material = lookup_material(registry, slot->material);
+    Material *fallback = lookup_material(registry, mesh->material);
+    Texture *textures[4] = { 0 };
+
+    if (fallback) {
+        textures[0] = lookup_texture(registry, fallback->albedo);
+        textures[1] = lookup_texture(registry, fallback->normal);
+        textures[2] = lookup_texture(registry, fallback->metalness);
+        textures[3] = lookup_texture(registry, fallback->roughness);
+    }
+    Texture *metalness = NULL;
+    if (material) {
+        Texture *albedo = lookup_texture(registry, material->albedo);
+        Texture *normal = lookup_texture(registry, material->normal);
+        Texture *roughness = lookup_texture(registry, material->roughness);
+        metalness = lookup_texture(registry, material->metalness);
+
+        if (albedo) textures[0] = albedo;
+        if (normal) textures[1] = normal;
+        if (metalness) textures[2] = metalness;
+        if (roughness) textures[3] = roughness;
+    }
+
+    for (u32 i = 0; i < array_count(textures); i++) {
+        if (!textures[i]) continue;
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]->id);
+    }
+
+    // only a slot's own metal roughness texture can be packed, fallbacks never are
+    Shader *shader = lookup_shader(registry, mesh->shader);
+    if (shader) {
+        b32 packed = metalness && material->packed_metal_roughness;
+        set_uniform_int(shader->id, "packed_metal_roughness", packed);
+    }
+}
+
+CullCounts draw_submeshes(AssetRegistry *registry, MemoryArena *frame_arena, Mesh *mesh, u32 lod, Frustum *frustum, Vector3 camera_position)
+{
+    CullCounts culled = { 0 };
+    u32 bound_slot = 0xffffffff;
+
+    // all the boxes go through at once, without a frustum everything is inside
+    u8 *results = NULL;
+    if (frustum) {
+        u32 count = mesh->num_submeshes;
+        Vector3Array centres = push_vector3_array(frame_arena, count);
+        Vector3Array extents = push_vector3_array(frame_arena, count);
+        for (u32 i = 0; i < count; i++) {
+            Vector3 centre = aabb_centre(mesh->submeshes[i].bounds);
+            Vector3 extent = aabb_extents(mesh->submeshes[i].bounds);
+            centres.x[i] = centre.x;
+            centres.y[i] = centre.y;
+            centres.z[i] = centre.z;
+            extents.x[i] = extent.x;
+            extents.y[i] = extent.y;
+            extents.z[i] = extent.z;
         }
+
+        results = push_array(frame_arena, lane_count(count), u8);
+        culled.submeshes = cull_aabbs(frustum, centres, extents, count, results);
+    }
+
+    // visible neighbours with the same material are one draw, at coarser levels that's
+    // usually the whole slot
+    u32 range_offset = 0, range_count = 0;
+
+    for (u32 i = 0; i < mesh->num_submeshes; i++) {
+        Submesh *submesh = &mesh->submeshes[i];
+        u8 result = results ? results[i] : CULL_INSIDE;
+        if (result == CULL_OUTSIDE) continue;
+
+        if (submesh->material_slot != bound_slot) {
+            if (range_count) draw_mesh_range(mesh, range_offset, range_count);
+            range_count = 0;
+
+            bind_material_slot(registry, mesh, &mesh->material_slots[submesh->material_slot]);
+            bound_slot = submesh->material_slot;
+        }
+
+        if (lod == 0 && submesh->meshlet_count) {
+            // a submesh that's all inside has nothing to cull its meshlets against
+            Frustum *meshlet_frustum = (result == CULL_INSIDE) ? NULL : frustum;
+            culled.meshlets += draw_meshlets(frame_arena, mesh, submesh->meshlet_offset, submesh->meshlet_count, meshlet_frustum, camera_position);
+            continue;
+        }
+
+        MeshLod *range = &submesh->lods[lod];
+        if (range_count && range_offset + range_count == range->index_offset) {
+            range_count += range->index_count;
+            continue;
+        }
+
+        if (range_count) draw_mesh_range(mesh, range_offset, range_count);
+        range_offset = range->index_offset;
+        range_count = range->index_count;
     }
+
+    if (range_count) draw_mesh_range(mesh, range_offset, range_count);
+
+    return culled;
 }
 
-Mesh *load_mesh_from_file(MemoryArena *arena, const char *file_name)
+void set_mesh_uniforms(GLuint shader_id, Mesh *mesh)
+{
+    set_uniform_vec3(shader_id, "position_offset", mesh->position_offset);
+    set_uniform_vec3(shader_id, "position_scale", mesh->position_scale);
+    set_uniform_vec2(shader_id, "texcoord_offset", mesh->texcoord_offset);
+    set_uniform_vec2(shader_id, "texcoord_scale", mesh->texcoord_scale);
+    set_uniform_int(shader_id, "octahedral_normals", mesh->vertex_format == VERTEX_FORMAT_PACKED);
+}
+
+// OBJ parsing works directly on the memory mapped file. Nothing is copied out
+// line by line, the tokenizer just walks a pointer towards the end of the view.
+//
+// Large files are split into line aligned chunks that are parsed on the work queue.
+// A counting pass finds how many v/vt/vn records each chunk has, the prefix sums of
+// those counts tell every chunk where its elements go, so indices resolve exactly as
+// in a serial parse. Face corners are parsed into per chunk arrays and merged last.
+//
+// o, g and usemtl lines are marked against the chunk's corner count as they're seen,
+// once the chunks are merged the marks split the corners into groups.
+//
+// Everything the parse builds lives in one scratch reservation. Each chunk grows its
+// corners in a range of its own, sized for the most the chunk's bytes could hold, only
+// what's used gets committed. Marks are few, every chunk pushes them on one shared atomic
+// arena and links its own in order.
+
+#define OBJ_MAX_CHUNKS 64
+#define OBJ_MIN_CHUNK_SIZE kilobytes(256)
+
+typedef enum ObjMarkType {
+    OBJ_MARK_OBJECT,
+    OBJ_MARK_MATERIAL,
+    OBJ_MARK_MATERIAL_LIBRARY
+} ObjMarkType;
+
+typedef struct ObjMark {
+    u32 corner; // corners the chunk had parsed when the line was reached
+    ObjMarkType type;
+    char *name; // the rest of the line in the file
+    struct ObjMark *next;
+} ObjMark;
+
+// 0 based, -1 when the corner doesn't reference one
+typedef struct ObjCorner {
+    s32 position;
+    s32 texcoord;
+    s32 normal;
+} ObjCorner;
+
+typedef struct ObjGroup {
+    u32 first_corner;
+    char object[MAX_SUBMESH_NAME];
+    char material[MAX_SUBMESH_NAME];
+} ObjGroup;
+
+typedef struct ObjData {
+    MemoryArena scratch;
+    AtomicArena mark_arena;
+
+    Vector3 *positions;
+    Vector2 *texcoords;
+    Vector3 *normals;
+
+    ObjCorner *corners; // three per triangle
+    u32 num_corners;
+
+    // corners first_corner up to the next group's first_corner, empty groups are allowed
+    ObjGroup *groups;
+    u32 num_groups;
+    char material_library[256];
+} ObjData;
+
+typedef struct ObjChunk {
+    ObjData *obj;
+    char *start;
+    char *end;
+
+    u32 num_positions, num_texcoords, num_normals, num_marks;
+    u32 position_base, texcoord_base, normal_base;
+    u32 next_position, next_texcoord, next_normal;
+
+    MemoryArena corner_arena;
+    GrowableArray corners;
+    ObjMark *first_mark, *last_mark;
+    u32 corner_base;
+} ObjChunk;
+
+static f64 powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline b32 is_digit(char c) { return (u32)(c - '0') < 10; }
+inline b32 is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static char *skip_blanks(char *at, char *end)
+{
+    while (at < end && is_blank(*at)) at++;
+    return at;
+}
+
+static char *skip_line(char *at, char *end)
 {
-    FILE *file;
-
-    Vector3 *positions = NULL;
-    Vector2 *texcoords = NULL;
-    Vector3 *normals = NULL;
-    s32 *position_index = NULL;
-    s32 *texcoord_index = NULL;
-    s32 *normal_index = NULL;
-
-    file = fopen(file_name, "rb");
-    assert(file != NULL);
-    while (1) {
-        char *line = read_line(file);
-        if (line == NULL) break;
-
-        if (strncmp(line, "v ", 2) == 0) { // positions
-            Vector3 position;
-            s32 items = sscanf(line + 2, "%f %f %f", &position.x, &position.y, &position.z);
-            assert(items == 3);
-            sb_push(positions, position);
-        } else if (strncmp(line, "vt ", 3) == 0) { // texcoords
-            Vector2 texcoord;
-            s32 items = sscanf(line + 3, "%f %f", &texcoord.x, &texcoord.y);
-            assert(items == 2);
-            sb_push(texcoords, texcoord);
-        } else if (strncmp(line, "vn ", 3) == 0) { // normals
-            Vector3 normal;
-            s32 items = sscanf(line + 3, "%f %f %f", &normal.x, &normal.y, &normal.z);
-            assert(items == 3);
-            sb_push(normals, normal);
-        } else if (strncmp(line, "f ", 2) == 0) { // faces
-            s32 position[3], texcoord[3], normal[3];
-#if 1 // helmet
-            s32 items = sscanf(line + 2, "%d/%d/%d %d/%d/%d %d/%d/%d",
-                &position[0], &texcoord[0], &normal[0],
-                &position[1], &texcoord[1], &normal[1],
-                &position[2], &texcoord[2], &normal[2]
-            );
-#else // teapot
-            s32 items = sscanf(line + 2, "%d %d %d", &position[0], &position[1], &position[2]);
-#endif
-            assert(items == 3 || items == 9);
-            for (s32 i = 0; i < 3; i++) {
-                sb_push(position_index, position[i] - 1);
-                sb_push(texcoord_index, texcoord[i] - 1);
-                sb_push(normal_index, normal[i] - 1);
+    char *newline = (char *)memchr(at, '\n', (usize)(end - at));
+    return newline ? newline + 1 : end;
+}
+
+static char *parse_s32(char *at, char *end, s32 *result)
+{
+    b32 negative = false;
+    if (at < end && (*at == '-' || *at == '+')) {
+        negative = (*at == '-');
+        at++;
+    }
+
+    s32 value = 0;
+    while (at < end && is_digit(*at)) {
+        value = value * 10 + (*at - '0');
+        at++;
+    }
+
+    *result = negative ? -value : value;
+    return at;
+}
+
+static char *parse_f32(char *at, char *end, f32 *result)
+{
+    b32 negative = false;
+    if (at < end && (*at == '-' || *at == '+')) {
+        negative = (*at == '-');
+        at++;
+    }
+
+    // accumulate up to 19 significant digits, anything past that only moves the exponent
+    u64 mantissa = 0;
+    s32 digits = 0;
+    s32 exponent = 0;
+    while (at < end && is_digit(*at)) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (u64)(*at - '0');
+            if (mantissa) digits++;
+        } else {
+            exponent++;
+        }
+        at++;
+    }
+
+    if (at < end && *at == '.') {
+        at++;
+        while (at < end && is_digit(*at)) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (u64)(*at - '0');
+                if (mantissa) digits++;
+                exponent--;
             }
+            at++;
         }
-        sb_free(line);
     }
-    fclose(file);
+
+    if (at < end && (*at == 'e' || *at == 'E')) {
+        s32 e;
+        at = parse_s32(at + 1, end, &e);
+        exponent += e;
+    }
+
+    f64 value = (f64)mantissa;
+    if (exponent < 0) {
+        value = (exponent >= -22) ? value / powers_of_ten[-exponent] : value * pow(10.0, exponent);
+    } else if (exponent > 0) {
+        value = (exponent <= 22) ? value * powers_of_ten[exponent] : value * pow(10.0, exponent);
+    }
+
+    *result = (f32)(negative ? -value : value);
+    return at;
+}
+
+static char *parse_floats(char *at, char *end, f32 *result, u32 count)
+{
+    for (u32 i = 0; i < count; i++) {
+        at = skip_blanks(at, end);
+        at = parse_f32(at, end, &result[i]);
+    }
+    return at;
+}
+
+// copies the rest of the line without its trailing blanks, names are cut to fit
+static char *parse_name(char *at, char *end, char *name, usize size)
+{
+    at = skip_blanks(at, end);
+
+    char *name_end = at;
+    while (name_end < end && *name_end != '\n') name_end++;
+    while (name_end > at && is_blank(name_end[-1])) name_end--;
+
+    usize length = (usize)(name_end - at);
+    if (length > size - 1) length = size - 1;
+    memcpy(name, at, length);
+    name[length] = 0;
+
+    return name_end;
+}
+
+static b32 starts_with(char *at, char *end, const char *keyword)
+{
+    usize length = strlen(keyword);
+    return (usize)(end - at) > length && memcmp(at, keyword, length) == 0 && is_blank(at[length]);
+}
+
+static void push_obj_mark(ObjChunk *chunk, ObjMarkType type, char *at)
+{
+    ObjMark *mark = push_struct_atomic(&chunk->obj->mark_arena, ObjMark);
+    mark->corner = (u32)chunk->corners.count;
+    mark->type = type;
+    mark->name = at;
+    mark->next = NULL;
+
+    if (chunk->last_mark) chunk->last_mark->next = mark;
+    else chunk->first_mark = mark;
+    chunk->last_mark = mark;
+}
+
+// obj indices are 1 based, negative indices count back from the last element
+inline s32 resolve_obj_index(s32 index, s32 count)
+{
+    s32 result = (index < 0) ? count + index : index - 1;
+    assert(result >= 0 && result < count);
+    return result;
+}
+
+static char *parse_face_corner(ObjChunk *chunk, char *at, char *end, ObjCorner *corner)
+{
+    s32 index;
+    at = parse_s32(at, end, &index);
+    corner->position = resolve_obj_index(index, chunk->next_position);
+    corner->texcoord = -1;
+    corner->normal = -1;
+
+    if (at < end && *at == '/') {
+        at++;
+        if (at < end && *at != '/') {
+            at = parse_s32(at, end, &index);
+            corner->texcoord = resolve_obj_index(index, chunk->next_texcoord);
+        }
+        if (at < end && *at == '/') {
+            at = parse_s32(at + 1, end, &index);
+            corner->normal = resolve_obj_index(index, chunk->next_normal);
+        }
+    }
+
+    return at;
+}
+
+static char *parse_face(ObjChunk *chunk, char *at, char *end)
+{
+    // polygons are triangulated as a fan around the first corner
+    ObjCorner first, previous, current;
+    u32 corners = 0;
+
+    at = skip_blanks(at, end);
+    while (at < end && (is_digit(*at) || *at == '-')) {
+        at = parse_face_corner(chunk, at, end, &current);
+
+        if (corners == 0) {
+            first = current;
+        } else if (corners >= 2) {
+            ObjCorner *triangle = array_add(&chunk->corners, 3, ObjCorner);
+            triangle[0] = first;
+            triangle[1] = previous;
+            triangle[2] = current;
+        }
+        previous = current;
+        corners++;
+
+        at = skip_blanks(at, end);
+    }
+    assert(corners >= 3);
+
+    return at;
+}
+
+static void count_obj_chunk(ObjChunk *chunk)
+{
+    char *at = chunk->start;
+    char *end = chunk->end;
+
+    while (at < end) {
+        at = skip_blanks(at, end);
+        if (at + 1 < end && *at == 'v') {
+            char next = at[1];
+            if (is_blank(next)) chunk->num_positions++;
+            else if (next == 't') chunk->num_texcoords++;
+            else if (next == 'n') chunk->num_normals++;
+        } else if (at + 1 < end && (*at == 'o' || *at == 'g') && is_blank(at[1])) {
+            chunk->num_marks++;
+        } else if (starts_with(at, end, "usemtl") || starts_with(at, end, "mtllib")) {
+            chunk->num_marks++;
+        }
+        at = skip_line(at, end);
+    }
+}
+
+static void parse_obj_chunk(ObjChunk *chunk)
+{
+    ObjData *obj = chunk->obj;
+    char *at = chunk->start;
+    char *end = chunk->end;
+
+    chunk->next_position = chunk->position_base;
+    chunk->next_texcoord = chunk->texcoord_base;
+    chunk->next_normal = chunk->normal_base;
+
+    // begun here so the arena belongs to the worker that fills it
+    chunk->corners = begin_array(&chunk->corner_arena, ObjCorner);
+
+    while (at < end) {
+        at = skip_blanks(at, end);
+        if (at >= end) break;
+
+        char c = *at;
+        char next = (at + 1 < end) ? at[1] : '\n';
+
+        if (c == 'v' && is_blank(next)) { // positions
+            at = parse_floats(at + 1, end, obj->positions[chunk->next_position++].elements, 3);
+        } else if (c == 'v' && next == 't') { // texcoords
+            at = parse_floats(at + 2, end, obj->texcoords[chunk->next_texcoord++].elements, 2);
+        } else if (c == 'v' && next == 'n') { // normals
+            at = parse_floats(at + 2, end, obj->normals[chunk->next_normal++].elements, 3);
+        } else if (c == 'f' && is_blank(next)) { // faces
+            at = parse_face(chunk, at + 1, end);
+        } else if ((c == 'o' || c == 'g') && is_blank(next)) { // objects and groups
+            push_obj_mark(chunk, OBJ_MARK_OBJECT, at + 1);
+        } else if (starts_with(at, end, "usemtl")) {
+            push_obj_mark(chunk, OBJ_MARK_MATERIAL, at + 6);
+        } else if (starts_with(at, end, "mtllib")) {
+            push_obj_mark(chunk, OBJ_MARK_MATERIAL_LIBRARY, at + 6);
+        }
+
+        at = skip_line(at, end);
+    }
+
+    assert(chunk->next_position == chunk->position_base + chunk->num_positions);
+    assert(chunk->next_texcoord == chunk->texcoord_base + chunk->num_texcoords);
+    assert(chunk->next_normal == chunk->normal_base + chunk->num_normals);
+}
+
+static void merge_obj_chunk(ObjChunk *chunk)
+{
+    ObjData *obj = chunk->obj;
+    if (chunk->corners.count)
+        memcpy(obj->corners + chunk->corner_base, chunk->corners.base, chunk->corners.count * sizeof(ObjCorner));
+}
+
+static PLATFORM_WORK_QUEUE_CALLBACK(count_obj_chunk_work) { count_obj_chunk((ObjChunk *)data); }
+static PLATFORM_WORK_QUEUE_CALLBACK(parse_obj_chunk_work) { parse_obj_chunk((ObjChunk *)data); }
+static PLATFORM_WORK_QUEUE_CALLBACK(merge_obj_chunk_work) { merge_obj_chunk((ObjChunk *)data); }
+
+static u32 split_obj_chunks(ObjChunk *chunks, ObjData *obj, char *start, char *end)
+{
+    usize size = (usize)(end - start);
+
+    // a few chunks per thread so uneven sections (all the faces come last) still balance
+    usize num_chunks = 4 * (get_worker_count() + 1);
+    if (num_chunks > size / OBJ_MIN_CHUNK_SIZE) num_chunks = size / OBJ_MIN_CHUNK_SIZE;
+    if (num_chunks > OBJ_MAX_CHUNKS) num_chunks = OBJ_MAX_CHUNKS;
+    if (num_chunks < 1) num_chunks = 1;
+
+    char *at = start;
+    for (u32 i = 0; i < num_chunks; i++) {
+        chunks[i].obj = obj;
+        chunks[i].start = at;
+        at = (i == num_chunks - 1) ? end : skip_line(start + get_chunk_start(size, i + 1, (u32)num_chunks), end);
+        if (at < chunks[i].start) at = chunks[i].start;
+        chunks[i].end = at;
+    }
+
+    return (u32)num_chunks;
+}
+
+// Fanned faces can't make more than three corners per byte.
+inline usize get_max_obj_corners(usize size) { return 3 * size + 3; }
+
+// a sub arena can lose a commit step to alignment and another to rounding its size up
+#define OBJ_SUB_ARENA_SLACK (2 * ARENA_COMMIT_SIZE)
+
+static void parse_obj(ObjData *obj, char *start, char *end)
+{
+    ObjChunk chunks[OBJ_MAX_CHUNKS] = { 0 };
+    u32 num_chunks = split_obj_chunks(chunks, obj, start, end);
+
+    run_chunks(count_obj_chunk_work, chunks, sizeof(ObjChunk), num_chunks);
+
+    u32 num_positions = 0, num_texcoords = 0, num_normals = 0, num_marks = 0;
+    for (u32 i = 0; i < num_chunks; i++) {
+        chunks[i].position_base = num_positions;
+        chunks[i].texcoord_base = num_texcoords;
+        chunks[i].normal_base = num_normals;
+        num_positions += chunks[i].num_positions;
+        num_texcoords += chunks[i].num_texcoords;
+        num_normals += chunks[i].num_normals;
+        num_marks += chunks[i].num_marks;
+    }
+
+    // every group after the first starts at a mark
+    usize size = (usize)(end - start);
+    usize scratch_size = num_positions * sizeof(Vector3) + num_texcoords * sizeof(Vector2) + num_normals * sizeof(Vector3) +
+        get_max_obj_corners(size) * sizeof(ObjCorner) + ((usize)num_marks + 1) * sizeof(ObjGroup) + 8 * DEFAULT_ALIGNMENT;
+    usize mark_arena_size = ((usize)num_marks + 1) * align_up(sizeof(ObjMark), DEFAULT_ALIGNMENT);
+    scratch_size += mark_arena_size + OBJ_SUB_ARENA_SLACK;
+    for (u32 i = 0; i < num_chunks; i++) {
+        usize chunk_size = (usize)(chunks[i].end - chunks[i].start);
+        scratch_size += get_max_obj_corners(chunk_size) * sizeof(ObjCorner) + OBJ_SUB_ARENA_SLACK;
+    }
+    reserve_scratch_arena(&obj->scratch, scratch_size);
+
+    obj->positions = push_array(&obj->scratch, num_positions, Vector3);
+    obj->texcoords = push_array(&obj->scratch, num_texcoords, Vector2);
+    obj->normals = push_array(&obj->scratch, num_normals, Vector3);
+
+    sub_atomic_arena(&obj->mark_arena, &obj->scratch, mark_arena_size);
+    for (u32 i = 0; i < num_chunks; i++) {
+        ObjChunk *chunk = &chunks[i];
+        usize chunk_size = (usize)(chunk->end - chunk->start);
+        sub_arena(&chunk->corner_arena, &obj->scratch, get_max_obj_corners(chunk_size) * sizeof(ObjCorner) + DEFAULT_ALIGNMENT);
+    }
+
+    run_chunks(parse_obj_chunk_work, chunks, sizeof(ObjChunk), num_chunks);
+
+    obj->num_corners = 0;
+    for (u32 i = 0; i < num_chunks; i++) {
+        chunks[i].corner_base = obj->num_corners;
+        obj->num_corners += (u32)chunks[i].corners.count;
+    }
+
+    obj->corners = push_array(&obj->scratch, obj->num_corners, ObjCorner);
+    run_chunks(merge_obj_chunk_work, chunks, sizeof(ObjChunk), num_chunks);
+
+    // a new group starts at every mark, marks before any faces just rename the current one
+    GrowableArray groups = begin_array(&obj->scratch, ObjGroup);
+    ObjGroup *current = array_add(&groups, 1, ObjGroup);
+    memset(current, 0, sizeof(ObjGroup));
+
+    for (u32 i = 0; i < num_chunks; i++) {
+        for (ObjMark *mark = chunks[i].first_mark; mark; mark = mark->next) {
+            if (mark->type == OBJ_MARK_MATERIAL_LIBRARY) {
+                if (!obj->material_library[0])
+                    parse_name(mark->name, end, obj->material_library, sizeof(obj->material_library));
+                continue;
+            }
+
+            u32 corner = chunks[i].corner_base + mark->corner;
+            if (current->first_corner != corner) {
+                ObjGroup *group = array_add(&groups, 1, ObjGroup);
+                *group = *current;
+                group->first_corner = corner;
+                current = group;
+            }
+
+            if (mark->type == OBJ_MARK_OBJECT)
+                parse_name(mark->name, end, current->object, sizeof(current->object));
+            else
+                parse_name(mark->name, end, current->material, sizeof(current->material));
+        }
+    }
+
+    obj->groups = (ObjGroup *)groups.base;
+    obj->num_groups = (u32)groups.count;
+}
+
+static void free_obj(ObjData *obj)
+{
+    release_scratch_arena(&obj->scratch);
+}
+
+inline u32 hash_vertex_key(s32 position, s32 texcoord, s32 normal)
+{
+    u32 h = (u32)position * 0x9e3779b1u;
+    h ^= (u32)texcoord * 0x85ebca77u;
+    h ^= (u32)normal * 0xc2b2ae3du;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+// Corners that reference the same position/texcoord/normal triple become one vertex.
+// indices gets the vertex of every corner, first_corner the corner each vertex was
+// first seen at. Returns the number of unique vertices.
+static u32 weld_obj_corners(ObjData *obj, u32 num_corners, u32 *indices, u32 *first_corner)
+{
+    // open addressing, kept at most half full so probe chains stay short
+    u32 table_size = 1;
+    while (table_size < num_corners * 2) table_size <<= 1;
+
+    MemoryArena *scratch = get_thread_scratch();
+    TemporaryMemory temporary = begin_temporary_memory(scratch);
+    u32 *table = push_array(scratch, table_size, u32);
+    memset(table, 0xff, table_size * sizeof(u32));
+
+    u32 num_vertices = 0;
+    for (u32 corner = 0; corner < num_corners; corner++) {
+        s32 position = obj->corners[corner].position;
+        s32 texcoord = obj->corners[corner].texcoord;
+        s32 normal = obj->corners[corner].normal;
+
+        // corners without a normal get their face's flat normal, so they can't be shared between faces
+        if (normal < 0) normal = -2 - (s32)(corner / 3);
+
+        u32 slot = hash_vertex_key(position, texcoord, normal) & (table_size - 1);
+        for (;;) {
+            u32 vertex = table[slot];
+            if (vertex == 0xffffffff) {
+                table[slot] = num_vertices;
+                first_corner[num_vertices] = corner;
+                indices[corner] = num_vertices++;
+                break;
+            }
+
+            u32 other = first_corner[vertex];
+            s32 other_normal = obj->corners[other].normal;
+            if (other_normal < 0) other_normal = -2 - (s32)(other / 3);
+
+            if (obj->corners[other].position == position && obj->corners[other].texcoord == texcoord && other_normal == normal) {
+                indices[corner] = vertex;
+                break;
+            }
+
+            slot = (slot + 1) & (table_size - 1);
+        }
+    }
+
+    end_temporary_memory(temporary);
+
+    return num_vertices;
+}
+
+static u32 find_material_slot(MaterialSlot *slots, u32 num_slots, const char *name)
+{
+    for (u32 i = 0; i < num_slots; i++) {
+        if (strcmp(slots[i].name, name) == 0) return i;
+    }
+    return num_slots;
+}
+
+// file_name relative to the directory of relative_to
+static void get_relative_path(char *path, usize size, const char *relative_to, const char *file_name)
+{
+    const char *slash = strrchr(relative_to, '/');
+    const char *backslash = strrchr(relative_to, '\\');
+    if (backslash > slash) slash = backslash;
+
+    s32 length = slash ? (s32)(slash - relative_to + 1) : 0;
+    snprintf(path, size, "%.*s%s", length, relative_to, file_name);
+}
+
+// Only the texture maps are read from the library, the PBR ones are the map_Pm/map_Pr
+// extension. Map options are skipped by taking the last word of the line.
+static void load_obj_materials(MaterialSlot *slots, u32 num_slots, const char *file_name)
+{
+    MappedFile file = map_file(file_name);
+    if (!file.data) {
+        printf("%s: material library not found\n", file_name);
+        return;
+    }
+
+    char *at = (char *)file.data;
+    char *end = at + file.size;
+    MaterialSlot *slot = NULL;
+
+    while (at < end) {
+        at = skip_blanks(at, end);
+
+        char name[256];
+        s32 texture = -1;
+        if (starts_with(at, end, "newmtl")) {
+            parse_name(at + 6, end, name, sizeof(name));
+            u32 index = find_material_slot(slots, num_slots, name);
+            slot = (index < num_slots) ? &slots[index] : NULL;
+        } else if (starts_with(at, end, "map_Kd")) {
+            texture = 0;
+        } else if (starts_with(at, end, "map_Bump") || starts_with(at, end, "map_bump") || starts_with(at, end, "bump") || starts_with(at, end, "norm")) {
+            texture = 1;
+        } else if (starts_with(at, end, "map_Pm")) {
+            texture = 2;
+        } else if (starts_with(at, end, "map_Pr")) {
+            texture = 3;
+        }
+
+        if (slot && texture >= 0) {
+            char *line_end = parse_name(at, end, name, sizeof(name));
+            char *word = line_end;
+            while (word > at && !is_blank(word[-1])) word--;
+
+            parse_name(word, line_end, name, sizeof(name));
+            get_relative_path(slot->texture_files[texture], sizeof(slot->texture_files[texture]), file_name, name);
+        }
+
+        at = skip_line(at, end);
+    }
+
+    unmap_file(&file);
+}
+
+// library gets the path of the mtllib the materials came from, empty without one.
+static Mesh *load_obj(MemoryArena *arena, const char *file_name, char *library, usize library_size)
+{
+    MappedFile file = map_file(file_name);
+    if (!file.data) {
+        printf("%s: file not found\n", file_name);
+        return NULL;
+    }
+
+    ObjData obj = { 0 };
+    parse_obj(&obj, (char *)file.data, (char *)file.data + file.size);
+    unmap_file(&file);
+
+    u32 num_corners = obj.num_corners;
+    u32 num_groups = obj.num_groups;
+
+    // loads run on the streaming thread too, its scratch is its own
+    MemoryArena *scratch = get_thread_scratch();
+    TemporaryMemory temporary = begin_temporary_memory(scratch);
+    u32 *welded = push_array(scratch, num_corners, u32);
+    u32 *first_corner = push_array(scratch, num_corners, u32);
 
     Mesh *mesh = push_struct(arena, Mesh);
-    mesh->num_vertices = sb_count(position_index);
-    mesh->num_indices = 3 * mesh->num_vertices;
+    memset(mesh, 0, sizeof(Mesh));
+    mesh->num_vertices = weld_obj_corners(&obj, num_corners, welded, first_corner);
+    mesh->vertices = push_array(arena, mesh->num_vertices, Vertex);
 
-    Vertex *vertices = NULL;
-    u32 *indices = NULL;
-    u32 offset = 0;
     for (u32 i = 0; i < mesh->num_vertices; i++) {
-        Vertex vertex;
-        vertex.position = positions[position_index[i]];
-        vertex.texcoord = texcoords[texcoord_index[i]];
-        vertex.normal = normals[normal_index[i]];
-        sb_push(vertices, vertex);
-        sb_push(indices, 0 + offset);
-        sb_push(indices, 1 + offset);
-        sb_push(indices, 2 + offset);
-        offset += 3;
+        ObjCorner *corner = &obj.corners[first_corner[i]];
+        Vertex *vertex = &mesh->vertices[i];
+
+        vertex->position = obj.positions[corner->position];
+        vertex->texcoord = (corner->texcoord >= 0) ? obj.texcoords[corner->texcoord] : vec2(0.0f, 0.0f);
+
+        if (corner->normal >= 0) {
+            vertex->normal = obj.normals[corner->normal];
+        } else {
+            // faces without normals get a flat one
+            ObjCorner *triangle = &obj.corners[first_corner[i] - first_corner[i] % 3];
+            Vector3 p0 = obj.positions[triangle[0].position];
+            Vector3 p1 = obj.positions[triangle[1].position];
+            Vector3 p2 = obj.positions[triangle[2].position];
+
+            Vector3 face_normal = vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0));
+            vertex->normal = (vec3_length_sq(face_normal) > 0.0f) ? vec3_norm(face_normal) : face_normal;
+        }
     }
 
-    mesh->vertices = push_array(arena, mesh->num_vertices, Vertex);
+    // a slot per distinct usemtl name in order of first use, faces before any usemtl get ""
+    mesh->material_slots = push_array(arena, num_groups, MaterialSlot);
+    u32 *group_slot = push_array(scratch, num_groups, u32);
+    for (u32 i = 0; i < num_groups; i++) {
+        u32 next = (i + 1 < num_groups) ? obj.groups[i + 1].first_corner : num_corners;
+        if (next == obj.groups[i].first_corner) {
+            group_slot[i] = 0xffffffff;
+            continue;
+        }
+
+        group_slot[i] = find_material_slot(mesh->material_slots, mesh->num_material_slots, obj.groups[i].material);
+        if (group_slot[i] == mesh->num_material_slots) {
+            MaterialSlot *slot = &mesh->material_slots[mesh->num_material_slots++];
+            memset(slot, 0, sizeof(MaterialSlot));
+            snprintf(slot->name, sizeof(slot->name), "%s", obj.groups[i].material);
+        }
+    }
+
+    // submeshes go in slot order, groups keep their file order within a slot. The indices
+    // are pushed last so the levels of detail can go on after them.
+    mesh->submeshes = push_array(arena, num_groups, Submesh);
+    mesh->num_indices = num_corners;
     mesh->indices = push_array(arena, mesh->num_indices, u32);
 
-    memcpy(mesh->vertices, vertices, sizeof(Vertex) * mesh->num_vertices);
-    memcpy(mesh->indices, indices, sizeof(u32) * mesh->num_indices);
+    u32 num_indices = 0;
+    for (u32 slot = 0; slot < mesh->num_material_slots; slot++) {
+        for (u32 i = 0; i < num_groups; i++) {
+            if (group_slot[i] != slot) continue;
 
-    upload_mesh(mesh);
+            u32 first = obj.groups[i].first_corner;
+            u32 count = ((i + 1 < num_groups) ? obj.groups[i + 1].first_corner : num_corners) - first;
+
+            memcpy(mesh->indices + num_indices, welded + first, count * sizeof(u32));
+
+            Submesh *submesh = &mesh->submeshes[mesh->num_submeshes++];
+            memset(submesh, 0, sizeof(Submesh));
+            snprintf(submesh->name, sizeof(submesh->name), "%s", obj.groups[i].object);
+            submesh->material_slot = slot;
+            submesh->lods[0].index_offset = num_indices;
+            submesh->lods[0].index_count = count;
+            num_indices += count;
+        }
+    }
+    assert(num_indices == num_corners);
+
+    if (obj.material_library[0]) {
+        get_relative_path(library, library_size, file_name, obj.material_library);
+        load_obj_materials(mesh->material_slots, mesh->num_material_slots, library);
+    }
 
-    sb_free(positions);
-    sb_free(texcoords);
-    sb_free(normals);
-    sb_free(position_index);
-    sb_free(texcoord_index);
-    sb_free(normal_index);
+    end_temporary_memory(temporary);
+    free_obj(&obj);
 
-    sb_free(vertices);
-    sb_free(indices);
+    generate_tangents(mesh, NULL);
 
     return mesh;
 }
 
-Mesh *create_skybox(MemoryArena *arena, const char *file_name)
+static AABB compute_bounds(Vertex *vertices, u32 num_vertices)
+{
+    AABB bounds = aabb_empty();
+    for (u32 i = 0; i < num_vertices; i++)
+        bounds = aabb_add_point(bounds, vertices[i].position);
+    return bounds;
+}
+
+static void compute_submesh_bounds(Mesh *mesh)
+{
+    for (u32 i = 0; i < mesh->num_submeshes; i++) {
+        Submesh *submesh = &mesh->submeshes[i];
+        u32 *indices = mesh->indices + submesh->lods[0].index_offset;
+
+        submesh->bounds = aabb_empty();
+        for (u32 j = 0; j < submesh->lods[0].index_count; j++)
+            submesh->bounds = aabb_add_point(submesh->bounds, mesh->vertices[indices[j]].position);
+    }
+}
+
+static b32 has_extension(const char *file_name, const char *extension)
 {
-    Mesh *sky_box = load_cube(arena);
-    sky_box->texture = generate_texture_cubemap(arena, file_name);
-    sky_box->shader = load_shader_from_file(arena, "../assets/shaders/skybox_vertex.glsl", "../assets/shaders/skybox_fragment.glsl");
+    usize length = strlen(file_name);
+    usize extension_length = strlen(extension);
+    return length >= extension_length && strcmp(file_name + length - extension_length, extension) == 0;
+}
 
-    return sky_box;
+static void get_baked_mesh_name(char *baked_name, usize size, const char *file_name)
+{
+    const char *dot = strrchr(file_name, '.');
+    const char *slash = strrchr(file_name, '/');
+    usize length = (dot && (!slash || dot > slash)) ? (usize)(dot - file_name) : strlen(file_name);
+
+    snprintf(baked_name, size, "%.*s.emesh", (s32)length, file_name);
 }
 
-Mesh *load_cube(MemoryArena *arena)
+// A level's range has to be inside the index array.
+inline b32 is_valid_baked_lod(MeshLod *lod, u32 num_indices)
 {
-    // temp! have some sort of mesh/asset libary so we dont reupload each time
-    Mesh *mesh = load_mesh_from_file(arena, "../assets/meshes/cube.obj");
+    return (u64)lod->index_offset + lod->index_count <= num_indices;
+}
+
+// Every range in the sections has to be inside the arrays it points into, a stale or cut
+// short bake that passes the header checks can't be allowed to draw past them.
+static b32 is_valid_baked_data(EmeshHeader *header, u8 *data)
+{
+    for (u32 i = 0; i < header->num_lods; i++) {
+        if (!is_valid_baked_lod(&header->lods[i], header->num_indices)) return false;
+    }
+
+    u32 *indices = (u32 *)(data + header->index_offset);
+    for (u32 i = 0; i < header->num_indices; i++) {
+        if (indices[i] >= header->num_vertices) return false;
+    }
+
+    Meshlet *meshlets = (Meshlet *)(data + header->meshlet_offset);
+    for (u32 i = 0; i < header->num_meshlets; i++) {
+        if ((u64)meshlets[i].index_offset + meshlets[i].index_count > header->num_indices) return false;
+    }
+
+    Submesh *submeshes = (Submesh *)(data + header->submesh_offset);
+    for (u32 i = 0; i < header->num_submeshes; i++) {
+        Submesh *submesh = &submeshes[i];
+        if (submesh->material_slot >= header->num_material_slots) return false;
+        if ((u64)submesh->meshlet_offset + submesh->meshlet_count > header->num_meshlets) return false;
+        for (u32 j = 0; j < header->num_lods; j++) {
+            if (!is_valid_baked_lod(&submesh->lods[j], header->num_indices)) return false;
+        }
+    }
+
+    return true;
+}
+
+// returns NULL if the file is missing, from another version, older than its source or
+// material library or has ranges that don't fit
+static Mesh *load_baked_mesh(MemoryArena *arena, const char *file_name, FileInfo *source)
+{
+    MappedFile file = map_file(file_name);
+    if (!file.data) return NULL;
+
+    EmeshHeader *header = (EmeshHeader *)file.data;
+    b32 valid = file.size >= sizeof(EmeshHeader) &&
+        header->magic == EMESH_MAGIC &&
+        header->version == EMESH_VERSION &&
+        header->flags == EMESH_FLAGS &&
+        header->num_lods >= 1 && header->num_lods <= MAX_MESH_LODS &&
+        header->vertex_size == sizeof(Vertex) &&
+        header->vertex_offset + (u64)header->num_vertices * sizeof(Vertex) <= file.size &&
+        header->index_offset + (u64)header->num_indices * sizeof(u32) <= file.size &&
+        header->meshlet_offset + (u64)header->num_meshlets * sizeof(Meshlet) <= file.size &&
+        header->submesh_offset + (u64)header->num_submeshes * sizeof(Submesh) <= file.size &&
+        header->material_slot_offset + (u64)header->num_material_slots * sizeof(EmeshMaterialSlot) <= file.size &&
+        header->string_size >= 1 && header->string_offset + header->string_size <= file.size;
+
+    // every string has to end inside the table
+    char *strings = valid ? (char *)file.data + header->string_offset : NULL;
+    valid = valid && strings[header->string_size - 1] == '\0';
+
+    EmeshMaterialSlot *baked_slots = valid ? (EmeshMaterialSlot *)(file.data + header->material_slot_offset) : NULL;
+    valid = valid && header->material_library < header->string_size;
+    for (u32 i = 0; valid && i < header->num_material_slots; i++) {
+        valid = baked_slots[i].name < header->string_size;
+        for (u32 j = 0; valid && j < array_count(baked_slots[i].texture_files); j++)
+            valid = baked_slots[i].texture_files[j] < header->string_size;
+    }
+
+    // a bake without its source is still good, there is nothing to rebuild it from
+    if (valid && source && source->exists) {
+        valid = header->source_size == source->size && header->source_write_time == source->write_time;
+
+        // an edited or deleted library changes the materials even when the source didn't
+        if (valid && header->material_library) {
+            FileInfo library = get_file_info(strings + header->material_library);
+            valid = library.size == header->library_size && library.write_time == header->library_write_time;
+        }
+    }
+
+    valid = valid && is_valid_baked_data(header, file.data);
+
+    if (!valid) {
+        unmap_file(&file);
+        return NULL;
+    }
+
+    Mesh *mesh = push_struct(arena, Mesh);
+    memset(mesh, 0, sizeof(Mesh));
+    mesh->num_vertices = header->num_vertices;
+    mesh->num_indices = header->num_indices;
+    mesh->num_meshlets = header->num_meshlets;
+    mesh->num_lods = header->num_lods;
+    mesh->bounds = header->bounds;
+    memcpy(mesh->lods, header->lods, sizeof(mesh->lods));
+
+    // the upload reads the arrays straight out of the file, which stays mapped until then
+    mesh->baked_file = file;
+    mesh->vertices = (Vertex *)(file.data + header->vertex_offset);
+    mesh->indices = (u32 *)(file.data + header->index_offset);
+
+    mesh->meshlets = push_array(arena, mesh->num_meshlets, Meshlet);
+    memcpy(mesh->meshlets, file.data + header->meshlet_offset, mesh->num_meshlets * sizeof(Meshlet));
+
+    mesh->num_submeshes = header->num_submeshes;
+    mesh->submeshes = push_array(arena, mesh->num_submeshes, Submesh);
+    memcpy(mesh->submeshes, file.data + header->submesh_offset, mesh->num_submeshes * sizeof(Submesh));
+
+    // the resolved materials were handles into another run
+    mesh->num_material_slots = header->num_material_slots;
+    mesh->material_slots = push_array(arena, mesh->num_material_slots, MaterialSlot);
+    for (u32 i = 0; i < mesh->num_material_slots; i++) {
+        EmeshMaterialSlot *baked = &baked_slots[i];
+        MaterialSlot *slot = &mesh->material_slots[i];
+        memset(slot, 0, sizeof(MaterialSlot));
+
+        snprintf(slot->name, sizeof(slot->name), "%s", strings + baked->name);
+        for (u32 j = 0; j < array_count(slot->texture_files); j++)
+            snprintf(slot->texture_files[j], sizeof(slot->texture_files[j]), "%s", strings + baked->texture_files[j]);
+        slot->gltf = baked->gltf;
+        memcpy(slot->texture_offsets, baked->texture_offsets, sizeof(slot->texture_offsets));
+        memcpy(slot->texture_sizes, baked->texture_sizes, sizeof(slot->texture_sizes));
+        slot->packed_metal_roughness = baked->packed_metal_roughness;
+    }
+
     return mesh;
 }
 
-Mesh *load_sphere(MemoryArena *arena)
+// Returns where string went in the table, empty strings all share offset 0.
+static u32 add_baked_string(char *strings, u32 *string_size, const char *string)
+{
+    if (!string[0]) return 0;
+
+    u32 offset = *string_size;
+    usize length = strlen(string) + 1;
+    memcpy(strings + offset, string, length);
+    *string_size += (u32)length;
+
+    return offset;
+}
+
+static void write_baked_mesh(Mesh *mesh, const char *file_name, FileInfo *source, const char *library)
 {
-    Mesh *mesh = load_mesh_from_file(arena, "../assets/meshes/sphere.obj");
+    MemoryArena *scratch = get_thread_scratch();
+    TemporaryMemory temporary = begin_temporary_memory(scratch);
+
+    // the longest each slot's strings could be, most are far shorter
+    EmeshMaterialSlot *baked_slots = push_array(scratch, mesh->num_material_slots, EmeshMaterialSlot);
+    usize library_length = strlen(library) + 1;
+    char *strings = push_array(scratch, 1 + library_length + mesh->num_material_slots * sizeof(MaterialSlot), char);
+    u32 string_size = 1;
+    strings[0] = '\0';
+
+    EmeshHeader header = { 0 };
+    header.material_library = add_baked_string(strings, &string_size, library);
+    if (library[0]) {
+        FileInfo library_info = get_file_info(library);
+        header.library_size = library_info.size;
+        header.library_write_time = library_info.write_time;
+    }
+
+    for (u32 i = 0; i < mesh->num_material_slots; i++) {
+        MaterialSlot *slot = &mesh->material_slots[i];
+        EmeshMaterialSlot *baked = &baked_slots[i];
+        memset(baked, 0, sizeof(EmeshMaterialSlot));
+
+        baked->name = add_baked_string(strings, &string_size, slot->name);
+        for (u32 j = 0; j < array_count(slot->texture_files); j++)
+            baked->texture_files[j] = add_baked_string(strings, &string_size, slot->texture_files[j]);
+        baked->gltf = slot->gltf;
+        memcpy(baked->texture_offsets, slot->texture_offsets, sizeof(baked->texture_offsets));
+        memcpy(baked->texture_sizes, slot->texture_sizes, sizeof(baked->texture_sizes));
+        baked->packed_metal_roughness = slot->packed_metal_roughness;
+    }
+
+    header.magic = EMESH_MAGIC;
+    header.version = EMESH_VERSION;
+    header.flags = EMESH_FLAGS;
+    header.vertex_size = sizeof(Vertex);
+    header.num_vertices = mesh->num_vertices;
+    header.num_indices = mesh->num_indices;
+    header.num_meshlets = mesh->num_meshlets;
+    header.num_lods = mesh->num_lods;
+    header.num_submeshes = mesh->num_submeshes;
+    header.num_material_slots = mesh->num_material_slots;
+    header.source_size = source->size;
+    header.source_write_time = source->write_time;
+    header.bounds = mesh->bounds;
+    memcpy(header.lods, mesh->lods, sizeof(header.lods));
+    header.vertex_offset = sizeof(EmeshHeader);
+    header.index_offset = header.vertex_offset + mesh->num_vertices * sizeof(Vertex);
+    header.meshlet_offset = header.index_offset + mesh->num_indices * sizeof(u32);
+    header.submesh_offset = header.meshlet_offset + mesh->num_meshlets * sizeof(Meshlet);
+    header.material_slot_offset = header.submesh_offset + mesh->num_submeshes * sizeof(Submesh);
+    header.string_offset = header.material_slot_offset + mesh->num_material_slots * sizeof(EmeshMaterialSlot);
+    header.string_size = string_size;
+
+    // read only asset folders just don't get a bake
+    FILE *file = fopen(file_name, "wb");
+    if (file) {
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(mesh->vertices, sizeof(Vertex), mesh->num_vertices, file);
+        fwrite(mesh->indices, sizeof(u32), mesh->num_indices, file);
+        fwrite(mesh->meshlets, sizeof(Meshlet), mesh->num_meshlets, file);
+        fwrite(mesh->submeshes, sizeof(Submesh), mesh->num_submeshes, file);
+        fwrite(baked_slots, sizeof(EmeshMaterialSlot), mesh->num_material_slots, file);
+        fwrite(strings, 1, string_size, file);
+        fclose(file);
+    }
+
+    end_temporary_memory(temporary);
+}
+
+// Everything up to the upload, safe to run off the main thread with its own arena. Files
+// that are missing or can't be read are drawn as a unit cube so the scene still loads.
+static Mesh *load_mesh_data(MemoryArena *arena, const char *file_name)
+{
+    Mesh *mesh = NULL;
+
+    if (has_extension(file_name, ".emesh")) {
+        mesh = load_baked_mesh(arena, file_name, NULL);
+        if (!mesh) printf("%s: invalid baked mesh, using a cube\n", file_name);
+    } else if (has_extension(file_name, ".glb") && (mesh = load_glb_direct(arena, file_name)) != NULL) {
+        // GL reads the file's own buffers, there's nothing to bake
+        return mesh;
+    } else {
+        char baked_name[512];
+        get_baked_mesh_name(baked_name, sizeof(baked_name), file_name);
+        char library[512] = { 0 };
+
+        FileInfo source = get_file_info(file_name);
+        mesh = load_baked_mesh(arena, baked_name, &source);
+        if (!mesh) {
+            mesh = has_extension(file_name, ".glb") ? load_glb(arena, file_name) : load_obj(arena, file_name, library, sizeof(library));
+            if (mesh) {
+                if (OPTIMISE_MESHES) optimise_mesh(mesh, file_name);
+                mesh->bounds = compute_bounds(mesh->vertices, mesh->num_vertices);
+                compute_submesh_bounds(mesh);
+                generate_mesh_lods(arena, mesh);
+                build_meshlets(arena, mesh);
+                write_baked_mesh(mesh, baked_name, &source, library);
+            } else {
+                printf("%s: couldn't be loaded, using a cube\n", file_name);
+            }
+        }
+    }
+
+    // the generators don't touch GL, the cube is uploaded or staged like any loaded mesh
+    if (!mesh) mesh = generate_cube(arena, 1);
+
+    mesh->vertex_format = PACK_VERTICES ? VERTEX_FORMAT_PACKED : VERTEX_FORMAT_FLOAT;
+
+    return mesh;
+}
+
+Mesh *load_mesh_from_file(MemoryArena *arena, const char *file_name)
+{
+    Mesh *mesh = load_mesh_data(arena, file_name);
+    upload_mesh(mesh);
+
     return mesh;
 }
 
@@ -1,21 +1,119 @@
 #ifndef MESH_H
 #define MESH_H
 
-#include "stb/stretchy_buffer.h"
+typedef struct AssetRegistry AssetRegistry;
 
 typedef struct Vertex {
     Vector3 position;
     Vector2 texcoord;
     Vector3 normal;
+    Vector4 tangent; // w is the bitangent sign
 } Vertex;
 
+// Compact GPU layout, a third of the size of Vertex. Everything is unsigned normalised so
+// it decodes the same on every GL version, the shaders rescale positions to the mesh
+// bounds and texcoords to their range and unfold the octahedral normal. The tangent
+// rides in position w as a 15 bit angle around the decoded normal plus the sign bit.
+typedef struct PackedVertex {
+    u16 position[4];
+    u16 texcoord[2];
+    u16 normal[2];
+} PackedVertex;
+
+typedef enum VertexFormat {
+    VERTEX_FORMAT_FLOAT,
+    VERTEX_FORMAT_PACKED,
+    VERTEX_FORMAT_EXTERNAL // float attributes laid out however the source file had them
+} VertexFormat;
+
+// Upload meshes as PackedVertex, vertex bandwidth matters more than the last bit of precision.
+#define PACK_VERTICES 1
+
+// A run of triangles in the index buffer small enough to cull on its own.
+// The cone apex and axis describe where the triangles can be seen from, none of them
+// face the camera when dot(normalize(cone_apex - camera), cone_axis) > cone_cutoff.
+typedef struct Meshlet {
+    u32 index_offset;
+    u32 index_count;
+
+    Sphere bounds;
+
+    Vector3 cone_apex;
+    Vector3 cone_axis;
+    f32 cone_cutoff;
+} Meshlet;
+
+// Simplified versions of the mesh share its vertices and live after the full
+// detail indices in the same index buffer. Level 0 is the full mesh.
+#define MAX_MESH_LODS 5
+
+typedef struct MeshLod {
+    u32 index_offset;
+    u32 index_count;
+    f32 error; // how far the simplified surface may be from the full one, in object space
+} MeshLod;
+
+typedef struct MeshHandle {
+    u32 value;
+} MeshHandle;
+
+typedef struct MaterialHandle {
+    u32 value;
+} MaterialHandle;
+
+// The textures stay in the registry's cache, destroying a material leaves them alone.
 typedef struct Material {
-    Texture *albedo;
-    Texture *normal;
-    Texture *metalness;
-    Texture *roughness;
+    TextureHandle albedo;
+    TextureHandle normal;
+    TextureHandle metalness;
+    TextureHandle roughness;
+
+    // glTF keeps metalness in blue and roughness in green of the same texture
+    b32 packed_metal_roughness;
 } Material;
 
+#define MAX_SUBMESH_NAME 64
+
+// A usemtl or glTF material, the texture files come from the mtllib or the glTF file and
+// are empty when it doesn't give one. material is filled in on the main thread, parts whose
+// slot has none draw with the mesh's material.
+typedef struct MaterialSlot {
+    char name[MAX_SUBMESH_NAME];
+    char texture_files[4][256]; // albedo, normal, metalness, roughness
+
+    // glTF images aren't flipped on load, embedded ones are a range of the file and
+    // size 0 is the whole file
+    b32 gltf;
+    u64 texture_offsets[4];
+    u32 texture_sizes[4];
+    b32 packed_metal_roughness;
+
+    MaterialHandle material;
+} MaterialSlot;
+
+// One o/g and usemtl group of the source. Submeshes are sorted by material slot and
+// each level of detail keeps them in that order, so drawing them in order switches
+// material as little as possible.
+typedef struct Submesh {
+    char name[MAX_SUBMESH_NAME];
+    u32 material_slot;
+
+    AABB bounds;
+
+    u32 meshlet_offset;
+    u32 meshlet_count;
+
+    MeshLod lods[MAX_MESH_LODS]; // the mesh's num_lods are valid
+} Submesh;
+
+// What goes into a mesh's GL buffers, vertex data first and then the indices.
+typedef struct MeshUpload {
+    u8 *data;
+    u32 vertex_size;
+    u32 index_size;
+    b32 borrowed; // data is the mesh's own, not freed with the upload
+} MeshUpload;
+
 typedef struct Mesh {
     Vertex *vertices;
     u32 num_vertices;
@@ -23,18 +121,123 @@ typedef struct Mesh {
     u32 *indices;
     u32 num_indices;
 
-    Shader *shader;
-    Material *material;
-    Texture *texture;
+    // baked meshes' vertices and indices point into the mapped file until the upload is prepared
+    MappedFile baked_file;
+
+    Meshlet *meshlets;
+    u32 num_meshlets;
+
+    // together they cover each level's index range, a mesh without faces has none
+    Submesh *submeshes;
+    u32 num_submeshes;
+
+    MaterialSlot *material_slots;
+    u32 num_material_slots;
+
+    MeshLod lods[MAX_MESH_LODS];
+    u32 num_lods;
+
+    AABB bounds;
+
+    // how the vertices were uploaded, position = offset + value * scale in the shaders
+    VertexFormat vertex_format;
+    Vector3 position_offset, position_scale;
+    Vector2 texcoord_offset, texcoord_scale;
+
+    // VERTEX_FORMAT_EXTERNAL meshes have no vertices or indices, just the source's buffer
+    // bytes. Attributes are position, texcoord, normal and tangent like Vertex.
+    u8 *external_data;
+    u32 external_vertex_size, external_index_size;
+    u32 attribute_offsets[4], attribute_strides[4];
+
+    // GL_UNSIGNED_SHORT for meshes with at most 65535 vertices
+    GLenum index_type;
+
+    // streamed meshes aren't drawable until their buffers are filled
+    b32 resident;
+
+    // meshes in the registry's pool own their meshlets, submeshes and material slots in
+    // this one heap block, see keep_mesh_draw_data
+    u8 *draw_data;
+
+    ShaderHandle shader;
+    MaterialHandle material;
 
     GLuint vertex_array, vertex_buffer, index_buffer;
+    u32 buffer_size; // bytes in both buffers, for the memory stats
 } Mesh;
 
+// Baked meshes hold the final vertex and index arrays so loading is one map and one upload.
+// The source file's size and write time are stored so stale bakes are rebuilt, and so are
+// its material library's.
+#define EMESH_MAGIC 0x48534d45 // "EMSH"
+#define EMESH_VERSION 10
+
+// Flags record which optional stages ran, a bake made with different settings is stale.
+#define EMESH_FLAG_OPTIMISED 0x1
+
+// Reorder indices and vertices for the post transform cache, overdraw and fetch on load.
+#define OPTIMISE_MESHES 1
+#define EMESH_FLAGS (OPTIMISE_MESHES ? EMESH_FLAG_OPTIMISED : 0)
+
+// A MaterialSlot in the file, the name and texture files are offsets into the string
+// table and 0 is the empty string.
+typedef struct EmeshMaterialSlot {
+    u32 name;
+    u32 texture_files[4];
+    b32 gltf;
+    u64 texture_offsets[4];
+    u32 texture_sizes[4];
+    b32 packed_metal_roughness;
+} EmeshMaterialSlot;
+
+typedef struct EmeshHeader {
+    u32 magic;
+    u32 version;
+    u32 vertex_size;
+    u32 num_vertices;
+    u32 num_indices;
+    u32 num_meshlets;
+    u32 num_lods;
+    u32 num_submeshes;
+    u32 num_material_slots;
+    u32 flags;
+
+    u64 source_size;
+    u64 source_write_time;
+
+    // the mtllib as the loader found it, an offset into the string table and 0 without one
+    u32 material_library;
+    u64 library_size;
+    u64 library_write_time;
+
+    AABB bounds;
+    MeshLod lods[MAX_MESH_LODS];
+
+    u64 vertex_offset;
+    u64 index_offset;
+    u64 meshlet_offset;
+    u64 submesh_offset;
+    u64 material_slot_offset;
+    u64 string_offset;
+    u64 string_size;
+} EmeshHeader;
+
 Mesh *load_mesh_from_file(MemoryArena *arena, const char *file_name);
-Mesh *create_skybox(MemoryArena *arena, const char *file_name);
+void set_mesh_uniforms(GLuint shader_id, Mesh *mesh);
+void draw_mesh_lod(Mesh *mesh, u32 lod);
+
+// What draw_submeshes left out, meshlets are only culled at level 0.
+typedef struct CullCounts {
+    u32 submeshes;
+    u32 meshlets;
+} CullCounts;
 
-Mesh *load_cube(MemoryArena *arena);
-Mesh *load_sphere(MemoryArena *arena);
+// Draws the submeshes inside the frustum at the given level, binding each material slot's
+// textures once. Level 0 culls meshlets as well. frustum and camera_position are in the
+// mesh's model space, frustum is null when the whole mesh is inside. Returns how many
+// submeshes and meshlets were culled, draw lists and culling scratch go in frame_arena.
+CullCounts draw_submeshes(AssetRegistry *registry, MemoryArena *frame_arena, Mesh *mesh, u32 lod, Frustum *frustum, Vector3 camera_position);
 void draw_quad(void);
 
 #endif /* MESH_H */
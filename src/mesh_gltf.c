@@ -0,0 +1,768 @@
+#include "mesh_gltf.h"
+
+// Nothing in the file is trusted, every accessor is checked against its buffer view and
+// the BIN chunk before anything reads through it.
+
+typedef struct GltfAccessor {
+    u8 *data;
+    u64 offset; // of data in the BIN chunk
+    u32 count;
+    u32 stride;
+    u32 element_size;
+    u32 component_type;
+    u32 components;
+    b32 normalized;
+} GltfAccessor;
+
+// A node of the scene that draws a mesh, with its transform from the root.
+typedef struct GltfInstance {
+    u32 mesh;
+    Matrix4x4 transform;
+} GltfInstance;
+
+typedef struct GltfPrimitive {
+    u32 instance;
+    u32 token;
+    u32 material_slot;
+    u32 block; // of vertices, load_glb only
+} GltfPrimitive;
+
+// Vertices are shared between primitives that use the same accessors in the same instance.
+typedef struct GltfVertexBlock {
+    u32 instance;
+    u32 accessors[4];
+    u32 first_vertex;
+    u32 count;
+    b32 flip_winding;
+} GltfVertexBlock;
+
+// A scene can reference the same node from many parents, these bound what a hostile file
+// can make the walk do and so how much scratch a load can need.
+#define GLTF_MAX_INSTANCES 65536
+#define GLTF_MAX_PRIMITIVES 65536
+#define GLTF_SCRATCH_SIZE (GLTF_MAX_INSTANCES * sizeof(GltfInstance) + \
+    GLTF_MAX_PRIMITIVES * (sizeof(GltfPrimitive) + sizeof(u32) + sizeof(GltfVertexBlock)) + kilobytes(64))
+
+typedef struct Glb {
+    MappedFile file;
+    Json json;
+
+    u8 *bin;
+    u64 bin_size;
+    u64 bin_offset; // where the BIN chunk's data starts in the file
+
+    // the scene walk's results, in scratch that goes with the Glb
+    MemoryArena scratch;
+    GltfInstance *instances;
+    u32 num_instances;
+    GltfPrimitive *primitives;
+    u32 num_primitives;
+} Glb;
+
+static const char *gltf_attributes[4] = { "POSITION", "TEXCOORD_0", "NORMAL", "TANGENT" };
+static const u32 gltf_attribute_components[4] = { 3, 2, 3, 4 };
+
+static void close_glb(Glb *glb)
+{
+    if (glb->scratch.base) release_scratch_arena(&glb->scratch);
+    free_json(&glb->json);
+    unmap_file(&glb->file);
+}
+
+static b32 open_glb(Glb *glb, const char *file_name)
+{
+    memset(glb, 0, sizeof(Glb));
+    glb->file = map_file(file_name);
+    if (!glb->file.data) {
+        printf("%s: file not found\n", file_name);
+        return false;
+    }
+
+    // the header, then the JSON chunk's length and type
+    u32 *header = (u32 *)glb->file.data;
+    b32 valid = glb->file.size >= 20 && header[0] == GLB_MAGIC && header[1] == 2 && header[2] <= glb->file.size &&
+        header[4] == GLB_CHUNK_JSON && 20 + (u64)header[3] <= header[2];
+
+    if (valid) {
+        // chunks are padded to 4 bytes, the BIN chunk is optional
+        u64 bin_chunk = 20 + (((u64)header[3] + 3) & ~3ull);
+        if (bin_chunk + 8 <= header[2]) {
+            u32 *chunk = (u32 *)(glb->file.data + bin_chunk);
+            valid = chunk[1] == GLB_CHUNK_BIN && bin_chunk + 8 + chunk[0] <= header[2];
+            glb->bin = glb->file.data + bin_chunk + 8;
+            glb->bin_size = chunk[0];
+            glb->bin_offset = bin_chunk + 8;
+        }
+
+        valid = valid && parse_json(&glb->json, (char *)glb->file.data + 20, header[3]);
+    }
+
+    if (!valid) {
+        printf("%s: not a valid GLB file\n", file_name);
+        close_glb(glb);
+        return false;
+    }
+
+    reserve_scratch_arena(&glb->scratch, GLTF_SCRATCH_SIZE);
+    return true;
+}
+
+// An index member like "mesh" or "bufferView", JSON_NONE when it's missing or nonsense.
+static u32 get_gltf_index(Json *json, u32 object, const char *key)
+{
+    f64 value = json_find_number(json, object, key, -1.0);
+    return (value >= 0.0 && value < (f64)JSON_NONE) ? (u32)value : JSON_NONE;
+}
+
+static u32 get_gltf_element(Json *json, const char *array, u32 index)
+{
+    return json_index(json, json_find(json, 0, array), index);
+}
+
+static u32 get_gltf_component_size(u32 component_type)
+{
+    switch (component_type) {
+        case GLTF_BYTE: case GLTF_UNSIGNED_BYTE: return 1;
+        case GLTF_SHORT: case GLTF_UNSIGNED_SHORT: return 2;
+        case GLTF_UNSIGNED_INT: case GLTF_FLOAT: return 4;
+    }
+    return 0;
+}
+
+// matrix types aren't vertex data, they count as invalid
+static u32 get_gltf_components(Json *json, u32 type)
+{
+    if (json_equals(json, type, "SCALAR")) return 1;
+    if (json_equals(json, type, "VEC2")) return 2;
+    if (json_equals(json, type, "VEC3")) return 3;
+    if (json_equals(json, type, "VEC4")) return 4;
+    return 0;
+}
+
+static b32 get_gltf_accessor(Glb *glb, u32 index, GltfAccessor *accessor)
+{
+    Json *json = &glb->json;
+    u32 token = get_gltf_element(json, "accessors", index);
+    u32 view = get_gltf_element(json, "bufferViews", get_gltf_index(json, token, "bufferView"));
+
+    // accessors without a view are all zeroes and sparse ones patch their view, neither is
+    // something GL can read so they are left out along with external buffers
+    if (view == JSON_NONE || json_find(json, token, "sparse") != JSON_NONE) return false;
+    if (get_gltf_index(json, view, "buffer") != 0 || !glb->bin) return false;
+
+    memset(accessor, 0, sizeof(GltfAccessor));
+    accessor->component_type = get_gltf_index(json, token, "componentType");
+    accessor->components = get_gltf_components(json, json_find(json, token, "type"));
+    accessor->normalized = json_equals(json, json_find(json, token, "normalized"), "true");
+    accessor->count = get_gltf_index(json, token, "count");
+
+    u32 component_size = get_gltf_component_size(accessor->component_type);
+    accessor->element_size = component_size * accessor->components;
+    if (!accessor->element_size || accessor->count == JSON_NONE || accessor->count == 0) return false;
+
+    f64 view_offset = json_find_number(json, view, "byteOffset", 0.0);
+    f64 view_length = json_find_number(json, view, "byteLength", -1.0);
+    f64 stride = json_find_number(json, view, "byteStride", (f64)accessor->element_size);
+    f64 offset = json_find_number(json, token, "byteOffset", 0.0);
+
+    if (view_offset < 0.0 || view_length < 0.0 || view_offset + view_length > (f64)glb->bin_size) return false;
+    if (stride < accessor->element_size || stride > 252.0 || offset < 0.0) return false;
+
+    // the last element has to end inside the view
+    accessor->stride = (u32)stride;
+    if (offset + (f64)(accessor->count - 1) * stride + accessor->element_size > view_length) return false;
+
+    accessor->offset = (u64)view_offset + (u64)offset;
+    if (accessor->offset % component_size || accessor->stride % component_size) return false;
+
+    accessor->data = glb->bin + accessor->offset;
+    return true;
+}
+
+static f32 read_gltf_component(GltfAccessor *accessor, u32 element, u32 component)
+{
+    u32 component_size = accessor->element_size / accessor->components;
+    u8 *at = accessor->data + (u64)element * accessor->stride + component * component_size;
+
+    switch (accessor->component_type) {
+        case GLTF_FLOAT: {
+            f32 value;
+            memcpy(&value, at, sizeof(value));
+            return value;
+        }
+        case GLTF_UNSIGNED_BYTE: return accessor->normalized ? (f32)*at / 255.0f : (f32)*at;
+        case GLTF_BYTE: return accessor->normalized ? fmaxf((f32)(s8)*at / 127.0f, -1.0f) : (f32)(s8)*at;
+        case GLTF_UNSIGNED_SHORT: {
+            u16 value;
+            memcpy(&value, at, sizeof(value));
+            return accessor->normalized ? (f32)value / 65535.0f : (f32)value;
+        }
+        case GLTF_SHORT: {
+            s16 value;
+            memcpy(&value, at, sizeof(value));
+            return accessor->normalized ? fmaxf((f32)value / 32767.0f, -1.0f) : (f32)value;
+        }
+    }
+    return 0.0f;
+}
+
+static Vector3 read_gltf_vec3(GltfAccessor *accessor, u32 element)
+{
+    return vec3(read_gltf_component(accessor, element, 0), read_gltf_component(accessor, element, 1), read_gltf_component(accessor, element, 2));
+}
+
+static u32 read_gltf_index(GltfAccessor *accessor, u32 element)
+{
+    u8 *at = accessor->data + (u64)element * accessor->stride;
+
+    switch (accessor->component_type) {
+        case GLTF_UNSIGNED_BYTE: return *at;
+        case GLTF_UNSIGNED_SHORT: {
+            u16 index;
+            memcpy(&index, at, sizeof(index));
+            return index;
+        }
+        case GLTF_UNSIGNED_INT: {
+            u32 index;
+            memcpy(&index, at, sizeof(index));
+            return index;
+        }
+    }
+    return 0xffffffff;
+}
+
+static Matrix4x4 get_gltf_node_transform(Json *json, u32 node)
+{
+    Matrix4x4 local = mat4(1.0f);
+
+    // glTF matrices are column major like ours
+    u32 matrix = json_find(json, node, "matrix");
+    if (matrix != JSON_NONE) {
+        for (u32 i = 0; i < 16; i++)
+            local.item[i] = (f32)json_number(json, json_index(json, matrix, i), (i % 5 == 0) ? 1.0 : 0.0);
+        return local;
+    }
+
+    u32 translation = json_find(json, node, "translation");
+    u32 rotation = json_find(json, node, "rotation");
+    u32 scale = json_find(json, node, "scale");
+
+    Vector3 t, s;
+    Quaternion r;
+    for (u32 i = 0; i < 3; i++) {
+        t.elements[i] = (f32)json_number(json, json_index(json, translation, i), 0.0);
+        s.elements[i] = (f32)json_number(json, json_index(json, scale, i), 1.0);
+    }
+    for (u32 i = 0; i < 4; i++)
+        r.elements[i] = (f32)json_number(json, json_index(json, rotation, i), (i == 3) ? 1.0 : 0.0);
+
+    return mat4_mul(mat4_translate(t), mat4_mul(quat_to_mat4(r), mat4_scale(s)));
+}
+
+static void collect_gltf_instances(Json *json, u32 node_index, Matrix4x4 parent, u32 depth, GrowableArray *instances)
+{
+    u32 node = get_gltf_element(json, "nodes", node_index);
+    if (node == JSON_NONE || depth > JSON_MAX_DEPTH || instances->count >= GLTF_MAX_INSTANCES) return;
+
+    Matrix4x4 transform = mat4_mul(parent, get_gltf_node_transform(json, node));
+
+    u32 mesh = get_gltf_index(json, node, "mesh");
+    if (mesh != JSON_NONE && get_gltf_element(json, "meshes", mesh) != JSON_NONE) {
+        GltfInstance instance = { mesh, transform };
+        array_push(instances, GltfInstance, instance);
+    }
+
+    u32 children = json_find(json, node, "children");
+    for (u32 i = 0; children != JSON_NONE && i < json->tokens[children].count; i++) {
+        f64 child = json_number(json, json_index(json, children, i), -1.0);
+        if (child >= 0.0 && child < (f64)JSON_NONE)
+            collect_gltf_instances(json, (u32)child, transform, depth + 1, instances);
+    }
+}
+
+// The meshes of the default scene, or every mesh once where it stands when there is no scene.
+static void get_gltf_instances(Glb *glb)
+{
+    Json *json = &glb->json;
+    GrowableArray instances = begin_array(&glb->scratch, GltfInstance);
+
+    u32 scene_index = get_gltf_index(json, 0, "scene");
+    u32 scene = get_gltf_element(json, "scenes", (scene_index == JSON_NONE) ? 0 : scene_index);
+
+    if (scene != JSON_NONE) {
+        u32 nodes = json_find(json, scene, "nodes");
+        for (u32 i = 0; nodes != JSON_NONE && i < json->tokens[nodes].count; i++) {
+            f64 node = json_number(json, json_index(json, nodes, i), -1.0);
+            if (node >= 0.0 && node < (f64)JSON_NONE)
+                collect_gltf_instances(json, (u32)node, mat4(1.0f), 0, &instances);
+        }
+    } else {
+        u32 meshes = json_find(json, 0, "meshes");
+        for (u32 i = 0; meshes != JSON_NONE && i < json->tokens[meshes].count && i < GLTF_MAX_INSTANCES; i++) {
+            GltfInstance instance = { i, mat4(1.0f) };
+            array_push(&instances, GltfInstance, instance);
+        }
+    }
+
+    glb->instances = (GltfInstance *)instances.base;
+    glb->num_instances = (u32)instances.count;
+}
+
+// Embedded images are read from the GLB itself at their offset, uri images from next to it.
+static void load_gltf_image(Glb *glb, const char *file_name, u32 texture_info, MaterialSlot *slot, u32 map)
+{
+    Json *json = &glb->json;
+    u32 texture = get_gltf_element(json, "textures", get_gltf_index(json, texture_info, "index"));
+    u32 image = get_gltf_element(json, "images", get_gltf_index(json, texture, "source"));
+    if (image == JSON_NONE) return;
+
+    u32 view = get_gltf_element(json, "bufferViews", get_gltf_index(json, image, "bufferView"));
+    u32 uri = json_find(json, image, "uri");
+
+    if (view != JSON_NONE) {
+        f64 offset = json_find_number(json, view, "byteOffset", 0.0);
+        f64 length = json_find_number(json, view, "byteLength", -1.0);
+        if (get_gltf_index(json, view, "buffer") != 0 || offset < 0.0 || length <= 0.0 || offset + length > (f64)glb->bin_size) return;
+
+        snprintf(slot->texture_files[map], sizeof(slot->texture_files[map]), "%s", file_name);
+        slot->texture_offsets[map] = glb->bin_offset + (u64)offset;
+        slot->texture_sizes[map] = (u32)length;
+    } else if (uri != JSON_NONE && json->tokens[uri].type == JSON_STRING) {
+        JsonToken *token = &json->tokens[uri];
+
+        // data URIs would need base64 decoding, GLB exporters don't write them
+        if (json_equals(json, uri, "") || (token->end - token->start >= 5 && memcmp(json->text + token->start, "data:", 5) == 0)) return;
+
+        // URIs are percent encoded, "my%20texture.png"
+        char name[256];
+        u32 length = 0;
+        for (u32 i = token->start; i < token->end && length + 1 < sizeof(name); i++) {
+            char c = json->text[i];
+            if (c == '%' && i + 2 < token->end) {
+                char hex[3] = { json->text[i + 1], json->text[i + 2], 0 };
+                c = (char)strtol(hex, NULL, 16);
+                i += 2;
+            }
+            name[length++] = c;
+        }
+        name[length] = 0;
+        get_relative_path(slot->texture_files[map], sizeof(slot->texture_files[map]), file_name, name);
+    }
+}
+
+static void load_gltf_material(Glb *glb, const char *file_name, u32 material_index, MaterialSlot *slot)
+{
+    Json *json = &glb->json;
+    memset(slot, 0, sizeof(MaterialSlot));
+    slot->gltf = true;
+
+    u32 material = get_gltf_element(json, "materials", material_index);
+    if (material == JSON_NONE) return;
+
+    u32 name = json_find(json, material, "name");
+    if (name != JSON_NONE && json->tokens[name].type == JSON_STRING) {
+        JsonToken *token = &json->tokens[name];
+        snprintf(slot->name, sizeof(slot->name), "%.*s", (s32)(token->end - token->start), json->text + token->start);
+    } else {
+        snprintf(slot->name, sizeof(slot->name), "material %u", material_index);
+    }
+
+    u32 pbr = json_find(json, material, "pbrMetallicRoughness");
+    load_gltf_image(glb, file_name, json_find(json, pbr, "baseColorTexture"), slot, 0);
+    load_gltf_image(glb, file_name, json_find(json, material, "normalTexture"), slot, 1);
+
+    // one image with roughness in green and metalness in blue
+    u32 metallic_roughness = json_find(json, pbr, "metallicRoughnessTexture");
+    load_gltf_image(glb, file_name, metallic_roughness, slot, 2);
+    load_gltf_image(glb, file_name, metallic_roughness, slot, 3);
+    slot->packed_metal_roughness = (slot->texture_files[2][0] != 0);
+}
+
+// The triangle primitives of every instance with their slot, a slot per glTF material in
+// order of first use. Primitives without a material share a slot with no textures. Returns
+// false when the scene has more than GLTF_MAX_PRIMITIVES.
+static b32 get_gltf_primitives(MemoryArena *arena, Glb *glb, const char *file_name, Mesh *mesh)
+{
+    Json *json = &glb->json;
+
+    u32 max_primitives = 0;
+    for (u32 i = 0; i < glb->num_instances; i++) {
+        u32 list = json_find(json, get_gltf_element(json, "meshes", glb->instances[i].mesh), "primitives");
+        if (list != JSON_NONE) max_primitives += json->tokens[list].count;
+        if (max_primitives > GLTF_MAX_PRIMITIVES) {
+            printf("%s: more than %u primitives\n", file_name, GLTF_MAX_PRIMITIVES);
+            return false;
+        }
+    }
+    mesh->material_slots = push_array(arena, max_primitives ? max_primitives : 1, MaterialSlot);
+
+    glb->primitives = push_array(&glb->scratch, max_primitives, GltfPrimitive);
+    glb->num_primitives = 0;
+    u32 *slot_materials = push_array(&glb->scratch, max_primitives, u32);
+
+    for (u32 i = 0; i < glb->num_instances; i++) {
+        u32 list = json_find(json, get_gltf_element(json, "meshes", glb->instances[i].mesh), "primitives");
+        for (u32 j = 0; list != JSON_NONE && j < json->tokens[list].count; j++) {
+            u32 token = json_index(json, list, j);
+            if (json_find_number(json, token, "mode", GLTF_TRIANGLES) != GLTF_TRIANGLES) {
+                printf("%s: skipping a primitive that isn't triangles\n", file_name);
+                continue;
+            }
+
+            u32 material = get_gltf_index(json, token, "material");
+            u32 slot = 0;
+            while (slot < mesh->num_material_slots && slot_materials[slot] != material) slot++;
+            if (slot == mesh->num_material_slots) {
+                load_gltf_material(glb, file_name, material, &mesh->material_slots[mesh->num_material_slots++]);
+                slot_materials[slot] = material;
+            }
+
+            GltfPrimitive primitive = { i, token, slot, 0 };
+            glb->primitives[glb->num_primitives++] = primitive;
+        }
+    }
+
+    return true;
+}
+
+static void copy_gltf_name(Json *json, u32 object, char *name, usize size)
+{
+    u32 token = json_find(json, object, "name");
+    if (token == JSON_NONE || json->tokens[token].type != JSON_STRING) return;
+    snprintf(name, size, "%.*s", (s32)(json->tokens[token].end - json->tokens[token].start), json->text + json->tokens[token].start);
+}
+
+static b32 is_identity(Matrix4x4 m)
+{
+    for (u32 i = 0; i < 16; i++) {
+        if (m.item[i] != ((i % 5 == 0) ? 1.0f : 0.0f)) return false;
+    }
+    return true;
+}
+
+Mesh *load_glb_direct(MemoryArena *arena, const char *file_name)
+{
+    Glb glb;
+    if (!open_glb(&glb, file_name)) return NULL;
+    Json *json = &glb.json;
+
+    get_gltf_instances(&glb);
+    b32 direct = glb.num_instances == 1 && is_identity(glb.instances[0].transform);
+
+    u32 list = direct ? json_find(json, get_gltf_element(json, "meshes", glb.instances[0].mesh), "primitives") : JSON_NONE;
+    u32 num_primitives = (list != JSON_NONE) ? json->tokens[list].count : 0;
+    direct = direct && num_primitives > 0;
+
+    // every primitive names the same four attribute accessors
+    u32 attribute_accessors[4] = { 0 };
+    for (u32 i = 0; direct && i < num_primitives; i++) {
+        u32 token = json_index(json, list, i);
+        u32 attributes = json_find(json, token, "attributes");
+        direct = json_find_number(json, token, "mode", GLTF_TRIANGLES) == GLTF_TRIANGLES;
+
+        for (u32 j = 0; direct && j < array_count(attribute_accessors); j++) {
+            u32 accessor = get_gltf_index(json, attributes, gltf_attributes[j]);
+            if (i == 0) attribute_accessors[j] = accessor;
+            direct = accessor != JSON_NONE && accessor == attribute_accessors[j];
+        }
+    }
+
+    GltfAccessor attributes[4];
+    u64 vertex_start = ~0ull, vertex_end = 0, vertex_bytes = 0;
+    for (u32 j = 0; direct && j < array_count(attributes); j++) {
+        GltfAccessor *attribute = &attributes[j];
+        direct = get_gltf_accessor(&glb, attribute_accessors[j], attribute) && attribute->component_type == GLTF_FLOAT &&
+            attribute->components == gltf_attribute_components[j] && attribute->count == attributes[0].count;
+        if (!direct) break;
+
+        u64 end = attribute->offset + (u64)(attribute->count - 1) * attribute->stride + attribute->element_size;
+        vertex_start = (attribute->offset < vertex_start) ? attribute->offset : vertex_start;
+        vertex_end = (end > vertex_end) ? end : vertex_end;
+        vertex_bytes += (u64)attribute->count * attribute->element_size;
+    }
+
+    // interleaved or one after the other is fine, anything else in between goes up with them
+    direct = direct && (f64)(vertex_end - vertex_start) <= (1.0 + GLTF_MAX_SPAN_WASTE) * (f64)vertex_bytes;
+
+    // the index accessors must be tightly packed u16 or u32 and together make one run
+    GltfAccessor *indices = (GltfAccessor *)allocate(MEMORY_TAG_MESH_BUILD, num_primitives * sizeof(GltfAccessor));
+    u64 index_start = ~0ull, index_end = 0, index_bytes = 0;
+    for (u32 i = 0; direct && i < num_primitives; i++) {
+        u32 token = json_index(json, list, i);
+        GltfAccessor *accessor = &indices[i];
+        direct = get_gltf_accessor(&glb, get_gltf_index(json, token, "indices"), accessor) && accessor->components == 1 &&
+            (accessor->component_type == GLTF_UNSIGNED_SHORT || accessor->component_type == GLTF_UNSIGNED_INT) &&
+            accessor->component_type == indices[0].component_type && accessor->stride == accessor->element_size &&
+            accessor->count % 3 == 0;
+        if (!direct) break;
+
+        u64 end = accessor->offset + (u64)accessor->count * accessor->element_size;
+        index_start = (accessor->offset < index_start) ? accessor->offset : index_start;
+        index_end = (end > index_end) ? end : index_end;
+        index_bytes += (u64)accessor->count * accessor->element_size;
+    }
+    direct = direct && index_end - index_start == index_bytes && index_bytes + (vertex_end - vertex_start) < 0xffffffff;
+
+    // GL doesn't check indices, every one in the run has to name a vertex
+    u32 index_size = direct ? indices[0].element_size : 0;
+    u32 num_indices = direct ? (u32)(index_bytes / index_size) : 0;
+    for (u32 i = 0; direct && i < num_indices; i++) {
+        GltfAccessor run = indices[0];
+        run.data = glb.bin + index_start;
+        direct = read_gltf_index(&run, i) < attributes[0].count;
+    }
+
+    Mesh *mesh = NULL;
+    if (direct) {
+        mesh = push_struct(arena, Mesh);
+        memset(mesh, 0, sizeof(Mesh));
+
+        // one block, the vertex span and then the index run, exactly as they are in the file
+        mesh->vertex_format = VERTEX_FORMAT_EXTERNAL;
+        mesh->num_vertices = attributes[0].count;
+        mesh->num_indices = num_indices;
+        mesh->index_type = (index_size == sizeof(u16)) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        mesh->external_vertex_size = (u32)(vertex_end - vertex_start);
+        mesh->external_index_size = (u32)index_bytes;
+        mesh->external_data = push_array(arena, mesh->external_vertex_size + mesh->external_index_size, u8);
+        memcpy(mesh->external_data, glb.bin + vertex_start, mesh->external_vertex_size);
+        memcpy(mesh->external_data + mesh->external_vertex_size, glb.bin + index_start, mesh->external_index_size);
+
+        for (u32 j = 0; j < array_count(attributes); j++) {
+            mesh->attribute_offsets[j] = (u32)(attributes[j].offset - vertex_start);
+            mesh->attribute_strides[j] = attributes[j].stride;
+        }
+
+        mesh->lods[0].index_count = num_indices;
+        mesh->num_lods = 1;
+
+        // submeshes go in slot order like the OBJ loader's, drawing them merges what's adjacent
+        b32 counted = get_gltf_primitives(arena, &glb, file_name, mesh);
+        mesh->submeshes = push_array(arena, num_primitives, Submesh);
+        mesh->bounds = aabb_empty();
+
+        for (u32 slot = 0; slot < mesh->num_material_slots; slot++) {
+            for (u32 i = 0; i < glb.num_primitives; i++) {
+                if (glb.primitives[i].material_slot != slot) continue;
+
+                GltfAccessor *accessor = &indices[i];
+                Submesh *submesh = &mesh->submeshes[mesh->num_submeshes++];
+                memset(submesh, 0, sizeof(Submesh));
+                copy_gltf_name(json, get_gltf_element(json, "meshes", glb.instances[0].mesh), submesh->name, sizeof(submesh->name));
+                submesh->material_slot = slot;
+                submesh->lods[0].index_offset = (u32)((accessor->offset - index_start) / index_size);
+                submesh->lods[0].index_count = accessor->count;
+
+                submesh->bounds = aabb_empty();
+                for (u32 k = 0; k < accessor->count; k++)
+                    submesh->bounds = aabb_add_point(submesh->bounds, read_gltf_vec3(&attributes[0], read_gltf_index(accessor, k)));
+                mesh->bounds.min = vec3_min(mesh->bounds.min, submesh->bounds.min);
+                mesh->bounds.max = vec3_max(mesh->bounds.max, submesh->bounds.max);
+            }
+        }
+
+        if (!counted) mesh = NULL;
+    }
+
+    deallocate(indices);
+    close_glb(&glb);
+
+    return mesh;
+}
+
+static b32 read_gltf_vertices(Glb *glb, GltfVertexBlock *block, Matrix4x4 transform, GrowableArray *vertices, b32 *missing_normals, b32 *missing_tangents)
+{
+    GltfAccessor attributes[4];
+    b32 present[4] = { 0 };
+
+    for (u32 j = 0; j < array_count(attributes); j++) {
+        if (block->accessors[j] == JSON_NONE) continue;
+        present[j] = get_gltf_accessor(glb, block->accessors[j], &attributes[j]);
+        if (!present[j] || attributes[j].components != gltf_attribute_components[j] || attributes[j].count != attributes[0].count) return false;
+    }
+    if (!present[0] || attributes[0].component_type != GLTF_FLOAT) return false;
+
+    // normals go through the cofactor matrix, the inverse transpose without the divide
+    Vector3 c0 = vec3(transform.elements[0][0], transform.elements[0][1], transform.elements[0][2]);
+    Vector3 c1 = vec3(transform.elements[1][0], transform.elements[1][1], transform.elements[1][2]);
+    Vector3 c2 = vec3(transform.elements[2][0], transform.elements[2][1], transform.elements[2][2]);
+    Vector3 n0 = vec3_cross(c1, c2), n1 = vec3_cross(c2, c0), n2 = vec3_cross(c0, c1);
+    f32 determinant = vec3_dot(c0, n0);
+    f32 sign = (determinant < 0.0f) ? -1.0f : 1.0f;
+
+    block->first_vertex = (u32)vertices->count;
+    block->count = attributes[0].count;
+    block->flip_winding = (determinant < 0.0f);
+
+    Vertex *added = array_add(vertices, block->count, Vertex);
+    for (u32 i = 0; i < block->count; i++) {
+        Vertex *vertex = &added[i];
+        memset(vertex, 0, sizeof(Vertex));
+
+        Vector3 p = read_gltf_vec3(&attributes[0], i);
+        Vector4 position = mat4_mul_vec4(transform, vec4(p.x, p.y, p.z, 1.0f));
+        vertex->position = vec3(position.x, position.y, position.z);
+
+        // glTF texcoords start top left, the same way the images are stored
+        if (present[1])
+            vertex->texcoord = vec2(read_gltf_component(&attributes[1], i, 0), read_gltf_component(&attributes[1], i, 1));
+
+        if (present[2]) {
+            Vector3 n = read_gltf_vec3(&attributes[2], i);
+            Vector3 normal = vec3_mul_float(vec3_add(vec3_add(vec3_mul_float(n0, n.x), vec3_mul_float(n1, n.y)), vec3_mul_float(n2, n.z)), sign);
+            vertex->normal = (vec3_length_sq(normal) > 0.0f) ? vec3_norm(normal) : normal;
+        }
+
+        if (present[3]) {
+            Vector3 t = read_gltf_vec3(&attributes[3], i);
+            Vector3 tangent = vec3_add(vec3_add(vec3_mul_float(c0, t.x), vec3_mul_float(c1, t.y)), vec3_mul_float(c2, t.z));
+            if (vec3_length_sq(tangent) > 0.0f) tangent = vec3_norm(tangent);
+            vertex->tangent = vec4(tangent.x, tangent.y, tangent.z, read_gltf_component(&attributes[3], i, 3) * sign);
+        }
+    }
+
+    if (!present[2]) *missing_normals = true;
+    if (!present[3]) *missing_tangents = true;
+
+    return true;
+}
+
+Mesh *load_glb(MemoryArena *arena, const char *file_name)
+{
+    Glb glb;
+    if (!open_glb(&glb, file_name)) return NULL;
+    Json *json = &glb.json;
+
+    Mesh *mesh = push_struct(arena, Mesh);
+    memset(mesh, 0, sizeof(Mesh));
+
+    get_gltf_instances(&glb);
+    b32 valid = get_gltf_primitives(arena, &glb, file_name, mesh) && glb.num_primitives > 0;
+    b32 missing_normals = false, missing_tangents = false;
+
+    mesh->submeshes = push_array(arena, glb.num_primitives ? glb.num_primitives : 1, Submesh);
+
+    // the vertices and then the indices grow where they end up, nothing else goes on the
+    // arena until each is done
+    GrowableArray vertices = begin_array(arena, Vertex);
+    GrowableArray blocks = begin_array(&glb.scratch, GltfVertexBlock);
+
+    for (u32 i = 0; valid && i < glb.num_primitives; i++) {
+        GltfPrimitive *primitive = &glb.primitives[i];
+
+        GltfVertexBlock key = { 0 };
+        key.instance = primitive->instance;
+        u32 attribute_set = json_find(json, primitive->token, "attributes");
+        for (u32 j = 0; j < array_count(key.accessors); j++)
+            key.accessors[j] = get_gltf_index(json, attribute_set, gltf_attributes[j]);
+
+        GltfVertexBlock *existing = (GltfVertexBlock *)blocks.base;
+        for (primitive->block = 0; primitive->block < (u32)blocks.count; primitive->block++) {
+            GltfVertexBlock *block = &existing[primitive->block];
+            if (block->instance == key.instance && memcmp(block->accessors, key.accessors, sizeof(key.accessors)) == 0) break;
+        }
+        if (primitive->block == (u32)blocks.count) {
+            valid = read_gltf_vertices(&glb, &key, glb.instances[key.instance].transform, &vertices, &missing_normals, &missing_tangents);
+            array_push(&blocks, GltfVertexBlock, key);
+        }
+    }
+
+    GltfVertexBlock *vertex_blocks = (GltfVertexBlock *)blocks.base;
+    GrowableArray indices = begin_array(arena, u32);
+
+    for (u32 slot = 0; valid && slot < mesh->num_material_slots; slot++) {
+        for (u32 i = 0; valid && i < glb.num_primitives; i++) {
+            GltfPrimitive *primitive = &glb.primitives[i];
+            if (primitive->material_slot != slot) continue;
+            GltfVertexBlock *block = &vertex_blocks[primitive->block];
+
+            // without indices the vertices are the triangle list
+            GltfAccessor accessor;
+            u32 index_accessor = get_gltf_index(json, primitive->token, "indices");
+            u32 count = block->count;
+            if (index_accessor != JSON_NONE) {
+                valid = get_gltf_accessor(&glb, index_accessor, &accessor) && accessor.components == 1 && accessor.component_type != GLTF_FLOAT;
+                if (!valid) break;
+                count = accessor.count;
+            }
+            count -= count % 3;
+
+            u32 first_index = (u32)indices.count;
+            u32 *added = array_add(&indices, count, u32);
+            for (u32 k = 0; k < count; k++) {
+                u32 index = (index_accessor != JSON_NONE) ? read_gltf_index(&accessor, k) : k;
+                if (index >= block->count) {
+                    valid = false;
+                    break;
+                }
+
+                // mirroring transforms turn the faces inside out
+                u32 corner = (block->flip_winding && k % 3) ? k - k % 3 + 3 - k % 3 : k;
+                added[corner] = block->first_vertex + index;
+            }
+
+            Submesh *submesh = &mesh->submeshes[mesh->num_submeshes++];
+            memset(submesh, 0, sizeof(Submesh));
+            copy_gltf_name(json, get_gltf_element(json, "meshes", glb.instances[primitive->instance].mesh), submesh->name, sizeof(submesh->name));
+            submesh->material_slot = slot;
+            submesh->lods[0].index_offset = first_index;
+            submesh->lods[0].index_count = count;
+        }
+    }
+
+    if (valid) {
+        mesh->num_vertices = (u32)vertices.count;
+        mesh->num_indices = (u32)indices.count;
+        mesh->vertices = (Vertex *)vertices.base;
+        mesh->indices = (u32 *)indices.base;
+
+        // area weighted face normals for the vertices the file gave none
+        if (missing_normals) {
+            u8 *summed = (u8 *)allocate_cleared(MEMORY_TAG_MESH_BUILD, mesh->num_vertices);
+            for (u32 b = 0; b < (u32)blocks.count; b++) {
+                if (vertex_blocks[b].accessors[2] == JSON_NONE) memset(summed + vertex_blocks[b].first_vertex, 1, vertex_blocks[b].count);
+            }
+
+            for (u32 i = 0; i < mesh->num_indices; i += 3) {
+                u32 *corners = &mesh->indices[i];
+                Vector3 p0 = mesh->vertices[corners[0]].position;
+                Vector3 p1 = mesh->vertices[corners[1]].position;
+                Vector3 p2 = mesh->vertices[corners[2]].position;
+                Vector3 face_normal = vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0));
+
+                for (u32 k = 0; k < 3; k++) {
+                    if (summed[corners[k]]) mesh->vertices[corners[k]].normal = vec3_add(mesh->vertices[corners[k]].normal, face_normal);
+                }
+            }
+
+            for (u32 i = 0; i < mesh->num_vertices; i++) {
+                if (!summed[i]) continue;
+                Vector3 normal = mesh->vertices[i].normal;
+                mesh->vertices[i].normal = (vec3_length_sq(normal) > 0.0f) ? vec3_norm(normal) : vec3(0.0f, 1.0f, 0.0f);
+            }
+            deallocate(summed);
+        }
+
+        // generate_tangents works in texcoords that run up the image, glTF's run down it.
+        // Blocks that came with tangents keep them.
+        if (missing_tangents) {
+            u8 *generated = (u8 *)allocate_cleared(MEMORY_TAG_MESH_BUILD, mesh->num_vertices);
+            for (u32 b = 0; b < (u32)blocks.count; b++) {
+                if (vertex_blocks[b].accessors[3] == JSON_NONE) memset(generated + vertex_blocks[b].first_vertex, 1, vertex_blocks[b].count);
+            }
+
+            generate_tangents(mesh, generated);
+            for (u32 i = 0; i < mesh->num_vertices; i++) {
+                if (generated[i]) mesh->vertices[i].tangent.w = -mesh->vertices[i].tangent.w;
+            }
+            deallocate(generated);
+        }
+    } else {
+        printf("%s: invalid or unsupported primitive data\n", file_name);
+        mesh = NULL;
+    }
+
+    close_glb(&glb);
+
+    return mesh;
+}
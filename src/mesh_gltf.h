@@ -0,0 +1,33 @@
+#ifndef MESH_GLTF_H
+#define MESH_GLTF_H
+
+// Binary glTF 2.0, a 12 byte header and then a JSON chunk and the BIN chunk it points into.
+#define GLB_MAGIC 0x46546c67 // "glTF"
+#define GLB_CHUNK_JSON 0x4e4f534a
+#define GLB_CHUNK_BIN 0x004e4942
+
+// accessor componentType
+#define GLTF_BYTE 5120
+#define GLTF_UNSIGNED_BYTE 5121
+#define GLTF_SHORT 5122
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT 5125
+#define GLTF_FLOAT 5126
+
+#define GLTF_TRIANGLES 4
+
+// A vertex buffer span may hold this much data besides the attributes and still go up
+// directly, past that the gaps cost more GPU memory than converting.
+#define GLTF_MAX_SPAN_WASTE 0.5f
+
+// The meshes of the default scene as one Mesh, GL reads the file's own buffers. Returns NULL
+// unless every primitive shares float POSITION, NORMAL, TEXCOORD_0 and TANGENT accessors with
+// no node transform, and the index accessors are one contiguous u16 or u32 run.
+Mesh *load_glb_direct(MemoryArena *arena, const char *file_name);
+
+// The meshes of the default scene flattened into Vertex arrays with node transforms applied,
+// missing normals and tangents generated. Still needs the rest of the OBJ pipeline. Returns
+// NULL on files that aren't valid.
+Mesh *load_glb(MemoryArena *arena, const char *file_name);
+
+#endif /* MESH_GLTF_H */
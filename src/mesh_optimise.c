@@ -0,0 +1,338 @@
+#include "mesh_optimise.h"
+
+// Triangle order follows Tipsify (Sander, Nehab and Barczak 2007), which fans around
+// vertices still in the cache and jumps to a dead end when it runs out. The places it
+// has to jump split the index buffer into clusters, those get reordered so triangles
+// facing away from the mesh centre are drawn first and occlude the rest.
+
+TriangleAdjacency build_triangle_adjacency(u32 *indices, u32 num_indices, u32 num_vertices)
+{
+    TriangleAdjacency adjacency;
+    adjacency.offsets = (u32 *)allocate_cleared(MEMORY_TAG_MESH_BUILD, (num_vertices + 1) * sizeof(u32));
+    adjacency.triangles = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_indices * sizeof(u32));
+
+    for (u32 i = 0; i < num_indices; i++)
+        adjacency.offsets[indices[i] + 1]++;
+    for (u32 i = 0; i < num_vertices; i++)
+        adjacency.offsets[i + 1] += adjacency.offsets[i];
+
+    u32 *fill = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u32));
+    memcpy(fill, adjacency.offsets, num_vertices * sizeof(u32));
+    for (u32 i = 0; i < num_indices; i++)
+        adjacency.triangles[fill[indices[i]]++] = i / 3;
+    deallocate(fill);
+
+    return adjacency;
+}
+
+void free_triangle_adjacency(TriangleAdjacency *adjacency)
+{
+    deallocate(adjacency->offsets);
+    deallocate(adjacency->triangles);
+}
+
+// A vertex is in the FIFO if fewer than cache_size vertices were added after it.
+// Flushing the cache is just moving time cache_size steps forward.
+inline b32 cache_miss(u32 *cache_time, u32 *time, u32 vertex, u32 cache_size)
+{
+    if (*time - cache_time[vertex] > cache_size) {
+        cache_time[vertex] = (*time)++;
+        return true;
+    }
+    return false;
+}
+
+VertexCacheStats analyse_vertex_cache(u32 *indices, u32 num_indices, u32 num_vertices, u32 cache_size)
+{
+    VertexCacheStats stats = { 0 };
+    if (num_indices == 0) return stats;
+
+    u32 *cache_time = (u32 *)allocate_cleared(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u32));
+    u8 *used = (u8 *)allocate_cleared(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u8));
+    u32 time = cache_size + 1;
+
+    u32 misses = 0, num_used = 0;
+    for (u32 i = 0; i < num_indices; i++) {
+        u32 vertex = indices[i];
+        misses += cache_miss(cache_time, &time, vertex, cache_size);
+        if (!used[vertex]) {
+            used[vertex] = true;
+            num_used++;
+        }
+    }
+
+    stats.acmr = (f32)misses / (f32)(num_indices / 3);
+    stats.atvr = (f32)misses / (f32)num_used;
+
+    deallocate(cache_time);
+    deallocate(used);
+
+    return stats;
+}
+
+static u32 skip_dead_end(u32 *live, u32 *dead_end, u32 *dead_end_count, u32 *cursor, u32 num_vertices)
+{
+    // most recently used vertices that still have triangles left first
+    while (*dead_end_count) {
+        u32 vertex = dead_end[--(*dead_end_count)];
+        if (live[vertex]) return vertex;
+    }
+
+    // then anything left, in input order
+    while (*cursor < num_vertices) {
+        if (live[*cursor]) return *cursor;
+        (*cursor)++;
+    }
+
+    return 0xffffffff;
+}
+
+void optimise_vertex_cache(u32 *indices, u32 num_indices, u32 num_vertices, u32 cache_size)
+{
+    u32 num_triangles = num_indices / 3;
+    if (num_triangles == 0) return;
+
+    TriangleAdjacency adjacency = build_triangle_adjacency(indices, num_indices, num_vertices);
+
+    u32 *live = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u32));
+    for (u32 i = 0; i < num_vertices; i++)
+        live[i] = adjacency.offsets[i + 1] - adjacency.offsets[i];
+
+    u32 *cache_time = (u32 *)allocate_cleared(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u32));
+    u32 *dead_end = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_indices * sizeof(u32));
+    u32 *candidates = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_indices * sizeof(u32));
+    u32 *output = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_indices * sizeof(u32));
+    u8 *emitted = (u8 *)allocate_cleared(MEMORY_TAG_MESH_BUILD, num_triangles * sizeof(u8));
+
+    u32 time = cache_size + 1;
+    u32 cursor = 0;
+    u32 dead_end_count = 0;
+    u32 output_count = 0;
+
+    u32 fanning = skip_dead_end(live, dead_end, &dead_end_count, &cursor, num_vertices);
+    while (fanning != 0xffffffff) {
+        u32 num_candidates = 0;
+
+        // emit every remaining triangle around the fanning vertex
+        for (u32 i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; i++) {
+            u32 triangle = adjacency.triangles[i];
+            if (emitted[triangle]) continue;
+
+            for (u32 j = 0; j < 3; j++) {
+                u32 vertex = indices[triangle * 3 + j];
+                output[output_count++] = vertex;
+                dead_end[dead_end_count++] = vertex;
+                candidates[num_candidates++] = vertex;
+                live[vertex]--;
+                cache_miss(cache_time, &time, vertex, cache_size);
+            }
+            emitted[triangle] = true;
+        }
+
+        // next fan is the oldest candidate that will still be in the cache once its triangles are out
+        u32 next = 0xffffffff;
+        s32 best_priority = -1;
+        for (u32 i = 0; i < num_candidates; i++) {
+            u32 vertex = candidates[i];
+            if (!live[vertex]) continue;
+
+            s32 priority = 0;
+            if (time - cache_time[vertex] + 2 * live[vertex] <= cache_size)
+                priority = (s32)(time - cache_time[vertex]);
+
+            if (priority > best_priority) {
+                best_priority = priority;
+                next = vertex;
+            }
+        }
+
+        if (next == 0xffffffff)
+            next = skip_dead_end(live, dead_end, &dead_end_count, &cursor, num_vertices);
+
+        fanning = next;
+    }
+    assert(output_count == num_triangles * 3);
+
+    memcpy(indices, output, output_count * sizeof(u32));
+
+    deallocate(live);
+    deallocate(cache_time);
+    deallocate(dead_end);
+    deallocate(candidates);
+    deallocate(output);
+    deallocate(emitted);
+    free_triangle_adjacency(&adjacency);
+}
+
+typedef struct ClusterSortKey {
+    f32 key;
+    u32 cluster;
+} ClusterSortKey;
+
+static s32 compare_cluster_sort_keys(const void *a, const void *b)
+{
+    f32 key_a = ((ClusterSortKey *)a)->key;
+    f32 key_b = ((ClusterSortKey *)b)->key;
+    return (key_a < key_b) - (key_a > key_b);
+}
+
+static u32 triangle_cache_misses(u32 *indices, u32 triangle, u32 *cache_time, u32 *time, u32 cache_size)
+{
+    u32 misses = 0;
+    for (u32 j = 0; j < 3; j++)
+        misses += cache_miss(cache_time, time, indices[triangle * 3 + j], cache_size);
+    return misses;
+}
+
+void optimise_overdraw(u32 *indices, u32 num_indices, Vertex *vertices, u32 num_vertices, u32 cache_size, f32 threshold)
+{
+    u32 num_triangles = num_indices / 3;
+    if (num_triangles == 0) return;
+
+    u32 *cache_time = (u32 *)allocate_cleared(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u32));
+    u32 time = cache_size + 1;
+
+    // hard boundaries are where the cache optimiser jumped, all three vertices miss
+    u32 *hard_clusters = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, (num_triangles + 1) * sizeof(u32));
+    u32 num_hard_clusters = 0;
+    for (u32 i = 0; i < num_triangles; i++) {
+        if (triangle_cache_misses(indices, i, cache_time, &time, cache_size) == 3)
+            hard_clusters[num_hard_clusters++] = i;
+    }
+    if (num_hard_clusters == 0 || hard_clusters[0] != 0) {
+        memmove(hard_clusters + 1, hard_clusters, num_hard_clusters * sizeof(u32));
+        hard_clusters[0] = 0;
+        num_hard_clusters++;
+    }
+    hard_clusters[num_hard_clusters] = num_triangles;
+
+    // soft boundaries split hard clusters further wherever restarting from a cold cache
+    // has already paid for itself, that is the ACMR so far is close to the cluster's
+    u32 *clusters = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, (num_triangles + 1) * sizeof(u32));
+    u32 num_clusters = 0;
+    for (u32 i = 0; i < num_hard_clusters; i++) {
+        u32 start = hard_clusters[i];
+        u32 end = hard_clusters[i + 1];
+
+        time += cache_size + 1;
+        u32 cluster_misses = 0;
+        for (u32 t = start; t < end; t++)
+            cluster_misses += triangle_cache_misses(indices, t, cache_time, &time, cache_size);
+        f32 cluster_acmr = (f32)cluster_misses / (f32)(end - start);
+
+        time += cache_size + 1;
+        u32 misses = 0, count = 0;
+        clusters[num_clusters++] = start;
+        for (u32 t = start; t < end; t++) {
+            misses += triangle_cache_misses(indices, t, cache_time, &time, cache_size);
+            count++;
+
+            if (t + 1 < end && (f32)misses <= threshold * cluster_acmr * (f32)count) {
+                clusters[num_clusters++] = t + 1;
+                time += cache_size + 1;
+                misses = 0;
+                count = 0;
+            }
+        }
+    }
+    clusters[num_clusters] = num_triangles;
+
+    Vector3 mesh_centroid = vec3(0.0f, 0.0f, 0.0f);
+    for (u32 i = 0; i < num_indices; i++)
+        mesh_centroid = vec3_add(mesh_centroid, vertices[indices[i]].position);
+    mesh_centroid = vec3_mul_float(mesh_centroid, 1.0f / (f32)num_indices);
+
+    // clusters facing away from the centre are likely occluders, they go first
+    ClusterSortKey *sort_keys = (ClusterSortKey *)allocate(MEMORY_TAG_MESH_BUILD, num_clusters * sizeof(ClusterSortKey));
+    for (u32 i = 0; i < num_clusters; i++) {
+        Vector3 centroid = vec3(0.0f, 0.0f, 0.0f);
+        Vector3 normal = vec3(0.0f, 0.0f, 0.0f);
+        f32 area = 0.0f;
+
+        for (u32 t = clusters[i]; t < clusters[i + 1]; t++) {
+            Vector3 p0 = vertices[indices[t * 3 + 0]].position;
+            Vector3 p1 = vertices[indices[t * 3 + 1]].position;
+            Vector3 p2 = vertices[indices[t * 3 + 2]].position;
+
+            Vector3 n = vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0));
+            f32 a = vec3_length(n);
+
+            centroid = vec3_add(centroid, vec3_mul_float(vec3_add(vec3_add(p0, p1), p2), a / 3.0f));
+            normal = vec3_add(normal, n);
+            area += a;
+        }
+
+        f32 normal_length = vec3_length(normal);
+        if (area > 0.0f) centroid = vec3_mul_float(centroid, 1.0f / area);
+        if (normal_length > 0.0f) normal = vec3_mul_float(normal, 1.0f / normal_length);
+
+        sort_keys[i].key = vec3_dot(vec3_sub(centroid, mesh_centroid), normal);
+        sort_keys[i].cluster = i;
+    }
+
+    qsort(sort_keys, num_clusters, sizeof(ClusterSortKey), compare_cluster_sort_keys);
+
+    u32 *output = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_indices * sizeof(u32));
+    u32 output_count = 0;
+    for (u32 i = 0; i < num_clusters; i++) {
+        u32 cluster = sort_keys[i].cluster;
+        u32 start = clusters[cluster] * 3;
+        u32 count = (clusters[cluster + 1] - clusters[cluster]) * 3;
+        memcpy(output + output_count, indices + start, count * sizeof(u32));
+        output_count += count;
+    }
+    memcpy(indices, output, num_indices * sizeof(u32));
+
+    deallocate(output);
+    deallocate(sort_keys);
+    deallocate(clusters);
+    deallocate(hard_clusters);
+    deallocate(cache_time);
+}
+
+void optimise_vertex_fetch(Vertex *vertices, u32 num_vertices, u32 *indices, u32 num_indices)
+{
+    u32 *remap = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u32));
+    memset(remap, 0xff, num_vertices * sizeof(u32));
+
+    Vertex *original = (Vertex *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(Vertex));
+    memcpy(original, vertices, num_vertices * sizeof(Vertex));
+
+    // vertices are laid out in the order the index buffer first touches them
+    u32 next = 0;
+    for (u32 i = 0; i < num_indices; i++) {
+        u32 vertex = indices[i];
+        if (remap[vertex] == 0xffffffff) {
+            remap[vertex] = next;
+            vertices[next++] = original[vertex];
+        }
+        indices[i] = remap[vertex];
+    }
+
+    // unreferenced vertices are kept at the end so the count doesn't change
+    for (u32 i = 0; i < num_vertices; i++) {
+        if (remap[i] == 0xffffffff)
+            vertices[next++] = original[i];
+    }
+
+    deallocate(original);
+    deallocate(remap);
+}
+
+void optimise_mesh(Mesh *mesh, const char *name)
+{
+    VertexCacheStats before = analyse_vertex_cache(mesh->indices, mesh->num_indices, mesh->num_vertices, VERTEX_CACHE_SIZE);
+
+    // triangles stay within their submesh, the vertices are shared so fetch order is global
+    for (u32 i = 0; i < mesh->num_submeshes; i++) {
+        MeshLod *range = &mesh->submeshes[i].lods[0];
+        u32 *indices = mesh->indices + range->index_offset;
+        optimise_vertex_cache(indices, range->index_count, mesh->num_vertices, VERTEX_CACHE_SIZE);
+        optimise_overdraw(indices, range->index_count, mesh->vertices, mesh->num_vertices, VERTEX_CACHE_SIZE, OVERDRAW_THRESHOLD);
+    }
+    optimise_vertex_fetch(mesh->vertices, mesh->num_vertices, mesh->indices, mesh->num_indices);
+
+    VertexCacheStats after = analyse_vertex_cache(mesh->indices, mesh->num_indices, mesh->num_vertices, VERTEX_CACHE_SIZE);
+
+    printf("%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", name, before.acmr, after.acmr, before.atvr, after.atvr);
+}
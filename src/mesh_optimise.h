@@ -0,0 +1,32 @@
+#ifndef MESH_OPTIMISE_H
+#define MESH_OPTIMISE_H
+
+// Size of the FIFO post transform cache the optimiser targets and the stats simulate.
+#define VERTEX_CACHE_SIZE 16
+
+// Overdraw clusters may be split while their ACMR stays within this factor of the whole cluster's.
+#define OVERDRAW_THRESHOLD 1.05f
+
+typedef struct VertexCacheStats {
+    f32 acmr; // average cache miss ratio, vertex shader runs per triangle (0.5 - 3.0)
+    f32 atvr; // average transformed vertex ratio, vertex shader runs per vertex (1.0 best)
+} VertexCacheStats;
+
+// The triangles using vertex v are triangles[offsets[v]] up to triangles[offsets[v + 1]].
+typedef struct TriangleAdjacency {
+    u32 *offsets;
+    u32 *triangles;
+} TriangleAdjacency;
+
+TriangleAdjacency build_triangle_adjacency(u32 *indices, u32 num_indices, u32 num_vertices);
+void free_triangle_adjacency(TriangleAdjacency *adjacency);
+
+VertexCacheStats analyse_vertex_cache(u32 *indices, u32 num_indices, u32 num_vertices, u32 cache_size);
+
+void optimise_vertex_cache(u32 *indices, u32 num_indices, u32 num_vertices, u32 cache_size);
+void optimise_overdraw(u32 *indices, u32 num_indices, Vertex *vertices, u32 num_vertices, u32 cache_size, f32 threshold);
+void optimise_vertex_fetch(Vertex *vertices, u32 num_vertices, u32 *indices, u32 num_indices);
+
+void optimise_mesh(Mesh *mesh, const char *name);
+
+#endif /* MESH_OPTIMISE_H */
@@ -0,0 +1,361 @@
+#include "mesh_primitive.h"
+
+// Builds a mesh with exactly num_vertices and num_indices, the generators fill them in.
+static Mesh *begin_generated_mesh(MemoryArena *arena, u32 num_vertices, u32 num_indices)
+{
+    Mesh *mesh = push_struct(arena, Mesh);
+    memset(mesh, 0, sizeof(Mesh));
+
+    mesh->num_vertices = num_vertices;
+    mesh->vertices = push_array(arena, num_vertices, Vertex);
+    mesh->num_indices = num_indices;
+    mesh->indices = push_array(arena, num_indices, u32);
+
+    return mesh;
+}
+
+// Everything load_mesh_data does after parsing, one submesh and no simplified levels. The
+// mesh stays on the CPU, whoever asked for it uploads it.
+static Mesh *end_generated_mesh(MemoryArena *arena, Mesh *mesh)
+{
+    generate_tangents(mesh, NULL);
+    mesh->bounds = compute_bounds(mesh->vertices, mesh->num_vertices);
+
+    mesh->lods[0].index_offset = 0;
+    mesh->lods[0].index_count = mesh->num_indices;
+    mesh->lods[0].error = 0.0f;
+    mesh->num_lods = 1;
+
+    mesh->num_material_slots = 1;
+    mesh->material_slots = push_struct(arena, MaterialSlot);
+    memset(mesh->material_slots, 0, sizeof(MaterialSlot));
+
+    mesh->num_submeshes = 1;
+    mesh->submeshes = push_struct(arena, Submesh);
+    memset(mesh->submeshes, 0, sizeof(Submesh));
+    mesh->submeshes[0].bounds = mesh->bounds;
+    mesh->submeshes[0].lods[0] = mesh->lods[0];
+
+    build_meshlets(arena, mesh);
+
+    mesh->vertex_format = PACK_VERTICES ? VERTEX_FORMAT_PACKED : VERTEX_FORMAT_FLOAT;
+
+    return mesh;
+}
+
+// A square of (divisions + 1)^2 vertices around centre, u_axis and v_axis are half the
+// sides and cross(u_axis, v_axis) is the side the triangles face.
+static void generate_grid(Mesh *mesh, u32 *num_vertices, u32 *num_indices, Vector3 centre, Vector3 u_axis, Vector3 v_axis, u32 divisions)
+{
+    Vector3 normal = vec3_norm(vec3_cross(u_axis, v_axis));
+    u32 base = *num_vertices;
+
+    for (u32 j = 0; j <= divisions; j++) {
+        for (u32 i = 0; i <= divisions; i++) {
+            f32 s = (f32)i / (f32)divisions;
+            f32 t = (f32)j / (f32)divisions;
+
+            Vertex *vertex = &mesh->vertices[(*num_vertices)++];
+            vertex->position = vec3_add(centre, vec3_add(vec3_mul_float(u_axis, 2.0f * s - 1.0f), vec3_mul_float(v_axis, 2.0f * t - 1.0f)));
+            vertex->texcoord = vec2(s, t);
+            vertex->normal = normal;
+        }
+    }
+
+    u32 *indices = mesh->indices + *num_indices;
+    for (u32 j = 0; j < divisions; j++) {
+        for (u32 i = 0; i < divisions; i++) {
+            u32 a = base + j * (divisions + 1) + i;
+            u32 b = a + 1;
+            u32 c = a + divisions + 2;
+            u32 d = a + divisions + 1;
+
+            *indices++ = a; *indices++ = b; *indices++ = c;
+            *indices++ = a; *indices++ = c; *indices++ = d;
+        }
+    }
+    *num_indices += divisions * divisions * 6;
+}
+
+Mesh *generate_cube(MemoryArena *arena, u32 divisions)
+{
+    assert(divisions >= 1);
+
+    // normal, u and v of each face, u x v = normal
+    static f32 faces[6][3][3] = {
+        { {  1, 0, 0 }, { 0, 0, -1 }, { 0, 1,  0 } },
+        { { -1, 0, 0 }, { 0, 0,  1 }, { 0, 1,  0 } },
+        { { 0,  1, 0 }, { 1, 0,  0 }, { 0, 0, -1 } },
+        { { 0, -1, 0 }, { 1, 0,  0 }, { 0, 0,  1 } },
+        { { 0, 0,  1 }, { 1, 0,  0 }, { 0, 1,  0 } },
+        { { 0, 0, -1 }, { -1, 0, 0 }, { 0, 1,  0 } }
+    };
+
+    u32 face_vertices = (divisions + 1) * (divisions + 1);
+    Mesh *mesh = begin_generated_mesh(arena, 6 * face_vertices, 6 * divisions * divisions * 6);
+
+    u32 num_vertices = 0, num_indices = 0;
+    for (u32 i = 0; i < 6; i++) {
+        Vector3 normal = vec3(faces[i][0][0], faces[i][0][1], faces[i][0][2]);
+        Vector3 u_axis = vec3(faces[i][1][0], faces[i][1][1], faces[i][1][2]);
+        Vector3 v_axis = vec3(faces[i][2][0], faces[i][2][1], faces[i][2][2]);
+        generate_grid(mesh, &num_vertices, &num_indices, vec3_mul_float(normal, 0.5f), vec3_mul_float(u_axis, 0.5f), vec3_mul_float(v_axis, 0.5f), divisions);
+    }
+    assert(num_vertices == mesh->num_vertices && num_indices == mesh->num_indices);
+
+    return end_generated_mesh(arena, mesh);
+}
+
+Mesh *generate_plane(MemoryArena *arena, u32 divisions)
+{
+    assert(divisions >= 1);
+
+    Mesh *mesh = begin_generated_mesh(arena, (divisions + 1) * (divisions + 1), divisions * divisions * 6);
+
+    u32 num_vertices = 0, num_indices = 0;
+    generate_grid(mesh, &num_vertices, &num_indices, vec3(0.0f, 0.0f, 0.0f), vec3(0.5f, 0.0f, 0.0f), vec3(0.0f, 0.0f, -0.5f), divisions);
+
+    return end_generated_mesh(arena, mesh);
+}
+
+// Longitude runs clockwise seen from above so the texture isn't mirrored from outside.
+inline Vector3 sphere_point(f32 theta, f32 phi)
+{
+    return vec3(sinf(theta) * cosf(phi), cosf(theta), -sinf(theta) * sinf(phi));
+}
+
+Mesh *generate_uv_sphere(MemoryArena *arena, u32 segments, u32 rings)
+{
+    assert(segments >= 3 && rings >= 2);
+
+    // a pole row per end and segments + 1 columns for the rings in between
+    u32 num_vertices = 2 * segments + (rings - 1) * (segments + 1);
+    u32 num_indices = 2 * segments * 3 + (rings - 2) * segments * 6;
+    Mesh *mesh = begin_generated_mesh(arena, num_vertices, num_indices);
+
+    Vertex *vertex = mesh->vertices;
+    for (u32 j = 0; j < segments; j++) {
+        vertex->position = vec3(0.0f, 1.0f, 0.0f);
+        vertex->texcoord = vec2(((f32)j + 0.5f) / (f32)segments, 1.0f);
+        vertex->normal = vertex->position;
+        vertex++;
+    }
+    for (u32 i = 1; i < rings; i++) {
+        f32 theta = PI * (f32)i / (f32)rings;
+        for (u32 j = 0; j <= segments; j++) {
+            f32 phi = 2.0f * PI * (f32)j / (f32)segments;
+            vertex->position = sphere_point(theta, phi);
+            vertex->texcoord = vec2((f32)j / (f32)segments, 1.0f - (f32)i / (f32)rings);
+            vertex->normal = vertex->position;
+            vertex++;
+        }
+    }
+    for (u32 j = 0; j < segments; j++) {
+        vertex->position = vec3(0.0f, -1.0f, 0.0f);
+        vertex->texcoord = vec2(((f32)j + 0.5f) / (f32)segments, 0.0f);
+        vertex->normal = vertex->position;
+        vertex++;
+    }
+    assert(vertex == mesh->vertices + num_vertices);
+
+    // ring i starts after the top pole row
+    u32 first_ring = segments;
+    u32 bottom_pole = segments + (rings - 1) * (segments + 1);
+
+    u32 *indices = mesh->indices;
+    for (u32 j = 0; j < segments; j++) {
+        *indices++ = first_ring + j;
+        *indices++ = first_ring + j + 1;
+        *indices++ = j;
+    }
+    for (u32 i = 0; i < rings - 2; i++) {
+        for (u32 j = 0; j < segments; j++) {
+            u32 upper = first_ring + i * (segments + 1) + j;
+            u32 lower = upper + segments + 1;
+
+            *indices++ = lower; *indices++ = lower + 1; *indices++ = upper + 1;
+            *indices++ = lower; *indices++ = upper + 1; *indices++ = upper;
+        }
+    }
+    u32 last_ring = first_ring + (rings - 2) * (segments + 1);
+    for (u32 j = 0; j < segments; j++) {
+        *indices++ = bottom_pole + j;
+        *indices++ = last_ring + j + 1;
+        *indices++ = last_ring + j;
+    }
+    assert(indices == mesh->indices + num_indices);
+
+    return end_generated_mesh(arena, mesh);
+}
+
+inline Vector2 sphere_texcoord(Vector3 p)
+{
+    f32 u = atan2f(-p.z, p.x) / (2.0f * PI);
+    if (u < 0.0f) u += 1.0f;
+    f32 v = 1.0f - acosf(fmaxf(-1.0f, fminf(1.0f, p.y))) / PI;
+    return vec2(u, v);
+}
+
+// Returns the vertex halfway along the edge, made the first time either triangle asks for it.
+static u32 get_edge_midpoint(u32 *table, u32 table_size, Vector3 *positions, u32 *num_positions, u32 a, u32 b)
+{
+    u64 key = (a < b) ? ((u64)a << 32 | b) : ((u64)b << 32 | a);
+    u32 slot = (u32)((key * 0x9e3779b97f4a7c15ull) >> 32) & (table_size - 1);
+
+    // slots hold key and vertex as three u32s: low, high, vertex
+    for (;;) {
+        u32 *entry = table + slot * 3;
+        if (entry[2] == 0xffffffff) {
+            entry[0] = (u32)key;
+            entry[1] = (u32)(key >> 32);
+            entry[2] = *num_positions;
+            positions[(*num_positions)++] = vec3_norm(vec3_mul_float(vec3_add(positions[a], positions[b]), 0.5f));
+            return entry[2];
+        }
+        if (entry[0] == (u32)key && entry[1] == (u32)(key >> 32))
+            return entry[2];
+
+        slot = (slot + 1) & (table_size - 1);
+    }
+}
+
+Mesh *generate_icosphere(MemoryArena *arena, u32 subdivisions)
+{
+    f32 t = (1.0f + sqrtf(5.0f)) * 0.5f;
+    f32 base_positions[12][3] = {
+        { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+        { 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+        { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+    };
+    static u32 base_triangles[20][3] = {
+        { 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+        { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+        { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+        { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+    };
+
+    // V - E + F = 2 on every level, F = 20 * 4^n and E = 30 * 4^n
+    u32 num_triangles = 20u << (2 * subdivisions);
+    u32 num_positions = 10 * (num_triangles / 20) + 2;
+    Vector3 *positions = (Vector3 *)allocate(MEMORY_TAG_MESH_BUILD, num_positions * sizeof(Vector3));
+    u32 *triangles = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_triangles * 3 * sizeof(u32));
+    u32 *next_triangles = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_triangles * 3 * sizeof(u32));
+
+    for (u32 i = 0; i < 12; i++)
+        positions[i] = vec3_norm(vec3(base_positions[i][0], base_positions[i][1], base_positions[i][2]));
+    memcpy(triangles, base_triangles, sizeof(base_triangles));
+
+    u32 count = 20, used_positions = 12;
+    for (u32 level = 0; level < subdivisions; level++) {
+        // each edge is split once, the table holds twice as many slots as there are edges
+        u32 table_size = 1;
+        while (table_size < count * 3) table_size <<= 1;
+        u32 *table = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, table_size * 3 * sizeof(u32));
+        memset(table, 0xff, table_size * 3 * sizeof(u32));
+
+        u32 *out = next_triangles;
+        for (u32 i = 0; i < count; i++) {
+            u32 a = triangles[i * 3 + 0], b = triangles[i * 3 + 1], c = triangles[i * 3 + 2];
+            u32 ab = get_edge_midpoint(table, table_size, positions, &used_positions, a, b);
+            u32 bc = get_edge_midpoint(table, table_size, positions, &used_positions, b, c);
+            u32 ca = get_edge_midpoint(table, table_size, positions, &used_positions, c, a);
+
+            *out++ = a; *out++ = ab; *out++ = ca;
+            *out++ = b; *out++ = bc; *out++ = ab;
+            *out++ = c; *out++ = ca; *out++ = bc;
+            *out++ = ab; *out++ = bc; *out++ = ca;
+        }
+        deallocate(table);
+
+        u32 *swap = triangles;
+        triangles = next_triangles;
+        next_triangles = swap;
+        count *= 4;
+    }
+    assert(count == num_triangles && used_positions == num_positions);
+
+    // Triangles straddling the seam take copies of their u < 0.5 corners moved to u + 1,
+    // pole corners get the u in the middle of the other two, the first triangle at a pole
+    // keeps the original. Neither can be more than one per position and triangle, which
+    // bounds the vertex count.
+    Vertex *vertices = (Vertex *)allocate(MEMORY_TAG_MESH_BUILD, (num_positions + num_triangles * 3) * sizeof(Vertex));
+    u32 *seam_copy = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_positions * sizeof(u32));
+    memset(seam_copy, 0xff, num_positions * sizeof(u32));
+
+    for (u32 i = 0; i < num_positions; i++) {
+        vertices[i].position = positions[i];
+        vertices[i].normal = positions[i];
+        vertices[i].texcoord = sphere_texcoord(positions[i]);
+    }
+
+    u32 num_vertices = num_positions;
+    for (u32 i = 0; i < num_triangles; i++) {
+        u32 *corners = triangles + i * 3;
+
+        b32 pole[3];
+        f32 max_u = 0.0f;
+        for (u32 j = 0; j < 3; j++) {
+            Vector3 p = positions[corners[j]];
+            pole[j] = (p.x * p.x + p.z * p.z) < 1e-10f;
+            if (!pole[j]) max_u = fmaxf(max_u, vertices[corners[j]].texcoord.u);
+        }
+
+        for (u32 j = 0; j < 3; j++) {
+            u32 vertex = corners[j];
+            if (pole[j] || max_u - vertices[vertex].texcoord.u <= 0.5f) continue;
+
+            if (seam_copy[vertex] == 0xffffffff) {
+                seam_copy[vertex] = num_vertices;
+                vertices[num_vertices] = vertices[vertex];
+                vertices[num_vertices].texcoord.u += 1.0f;
+                num_vertices++;
+            }
+            corners[j] = seam_copy[vertex];
+        }
+
+        for (u32 j = 0; j < 3; j++) {
+            if (!pole[j]) continue;
+
+            f32 u = 0.0f;
+            for (u32 k = 0; k < 3; k++) {
+                if (k != j) u += vertices[corners[k]].texcoord.u * 0.5f;
+            }
+
+            if (seam_copy[corners[j]] == 0xffffffff) {
+                seam_copy[corners[j]] = corners[j];
+                vertices[corners[j]].texcoord.u = u;
+                continue;
+            }
+
+            vertices[num_vertices] = vertices[corners[j]];
+            vertices[num_vertices].texcoord.u = u;
+            corners[j] = num_vertices++;
+        }
+    }
+
+    Mesh *mesh = begin_generated_mesh(arena, num_vertices, num_triangles * 3);
+    memcpy(mesh->vertices, vertices, num_vertices * sizeof(Vertex));
+    memcpy(mesh->indices, triangles, num_triangles * 3 * sizeof(u32));
+
+    deallocate(seam_copy);
+    deallocate(vertices);
+    deallocate(next_triangles);
+    deallocate(triangles);
+    deallocate(positions);
+
+    return end_generated_mesh(arena, mesh);
+}
+
+MeshHandle load_cube(AssetRegistry *registry)
+{
+    MeshHandle mesh = find_generated_mesh(registry, "cube");
+    if (!mesh.value) {
+        TemporaryMemory temporary = begin_temporary_memory(registry->arena);
+        Mesh *cube = generate_cube(registry->arena, 1);
+        upload_mesh(cube);
+        mesh = add_generated_mesh(registry, "cube", cube);
+        end_temporary_memory(temporary);
+    }
+
+    return mesh;
+}
@@ -0,0 +1,28 @@
+#ifndef MESH_PRIMITIVE_H
+#define MESH_PRIMITIVE_H
+
+// Primitives are generated straight into the arena without touching a file or GL, so
+// they can stand in for a mesh that failed to load on any thread. Callers upload them.
+// Faces wind counter clockwise seen from outside and texcoords run 0 to 1 over each face
+// of the cube and plane and once around the spheres.
+
+// The unit cube, side 1 centred on the origin, each face split into divisions x divisions quads.
+Mesh *generate_cube(MemoryArena *arena, u32 divisions);
+
+// Side 1 in the xz plane facing +y, split into divisions x divisions quads.
+Mesh *generate_plane(MemoryArena *arena, u32 divisions);
+
+// Radius 1, segments around the y axis and rings from pole to pole. The seam column is
+// doubled for the texcoords, the poles get a vertex per segment.
+Mesh *generate_uv_sphere(MemoryArena *arena, u32 segments, u32 rings);
+
+// Radius 1, an icosahedron with every triangle split in four subdivisions times, so
+// 20 * 4^subdivisions evenly sized triangles. Mapped like the UV sphere, vertices on
+// the seam and poles are doubled for the triangles that need it.
+Mesh *generate_icosphere(MemoryArena *arena, u32 subdivisions);
+
+// Shared through the registry, generated the first time it's asked for. The pool keeps
+// what drawing needs and the generator's arena memory is given back.
+MeshHandle load_cube(AssetRegistry *registry);
+
+#endif /* MESH_PRIMITIVE_H */
@@ -0,0 +1,569 @@
+#include "mesh_simplify.h"
+
+// Edge collapse simplification driven by quadric error (Garland and Heckbert 1997), laid
+// out like meshoptimizer's simplifier. Vertices sharing a position are grouped into wedges,
+// every position is classified as manifold, border, seam or locked, and collapses only run
+// along edges that keep open borders and UV/normal seams where they are.
+
+typedef enum VertexKind {
+    VERTEX_KIND_MANIFOLD, // one wedge, no open edges
+    VERTEX_KIND_BORDER,   // one wedge on a single open edge loop
+    VERTEX_KIND_SEAM,     // two wedges splitting the attributes along one seam
+    VERTEX_KIND_LOCKED,   // anything more complicated, never moves
+    VERTEX_KIND_COUNT
+} VertexKind;
+
+static const u8 can_collapse[VERTEX_KIND_COUNT][VERTEX_KIND_COUNT] = {
+    { 1, 1, 1, 1 },
+    { 0, 1, 0, 0 },
+    { 0, 0, 1, 0 },
+    { 0, 0, 0, 0 },
+};
+
+// edges touching manifold or seam vertices are seen once from each side
+static const u8 has_opposite[VERTEX_KIND_COUNT][VERTEX_KIND_COUNT] = {
+    { 1, 1, 1, 1 },
+    { 1, 0, 1, 0 },
+    { 1, 1, 1, 1 },
+    { 1, 0, 1, 0 },
+};
+
+#define NO_VERTEX 0xffffffff
+
+typedef struct Quadric {
+    f32 a00, a11, a22;
+    f32 a10, a20, a21;
+    f32 b0, b1, b2;
+    f32 c;
+    f32 w;
+} Quadric;
+
+typedef struct Collapse {
+    u32 v0, v1;
+    b32 bidirectional;
+    f32 error;
+    f32 cost;
+} Collapse;
+
+static void quadric_from_plane(Quadric *q, Vector3 n, f32 d, f32 w)
+{
+    q->a00 = w * n.x * n.x;
+    q->a11 = w * n.y * n.y;
+    q->a22 = w * n.z * n.z;
+    q->a10 = w * n.y * n.x;
+    q->a20 = w * n.z * n.x;
+    q->a21 = w * n.z * n.y;
+    q->b0 = w * d * n.x;
+    q->b1 = w * d * n.y;
+    q->b2 = w * d * n.z;
+    q->c = w * d * d;
+    q->w = w;
+}
+
+static void quadric_add(Quadric *q, Quadric *other)
+{
+    q->a00 += other->a00;
+    q->a11 += other->a11;
+    q->a22 += other->a22;
+    q->a10 += other->a10;
+    q->a20 += other->a20;
+    q->a21 += other->a21;
+    q->b0 += other->b0;
+    q->b1 += other->b1;
+    q->b2 += other->b2;
+    q->c += other->c;
+    q->w += other->w;
+}
+
+// squared distance to the planes, averaged by their weight
+static f32 quadric_error(Quadric *q, Vector3 v)
+{
+    f32 r = q->a00 * v.x * v.x + q->a11 * v.y * v.y + q->a22 * v.z * v.z;
+    r += 2.0f * (q->a10 * v.x * v.y + q->a20 * v.x * v.z + q->a21 * v.y * v.z);
+    r += 2.0f * (q->b0 * v.x + q->b1 * v.y + q->b2 * v.z);
+    r += q->c;
+
+    return (q->w > 0.0f) ? fabsf(r) / q->w : 0.0f;
+}
+
+// weighted by the square root of the area so the error scales linearly with size
+static void quadric_from_triangle(Quadric *q, Vector3 p0, Vector3 p1, Vector3 p2)
+{
+    Vector3 normal = vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0));
+    f32 length = vec3_length(normal);
+    if (length > 0.0f) normal = vec3_mul_float(normal, 1.0f / length);
+
+    quadric_from_plane(q, normal, -vec3_dot(normal, p0), (f32)sqrt(length * 0.5f));
+}
+
+// plane through the edge at right angles to its triangle
+static void quadric_from_triangle_edge(Quadric *q, Vector3 p0, Vector3 p1, Vector3 p2, f32 weight)
+{
+    Vector3 edge = vec3_sub(p1, p0);
+    f32 length = vec3_length(edge);
+    if (length > 0.0f) edge = vec3_mul_float(edge, 1.0f / length);
+
+    Vector3 to_p2 = vec3_sub(p2, p0);
+    Vector3 normal = vec3_sub(to_p2, vec3_mul_float(edge, vec3_dot(to_p2, edge)));
+    f32 normal_length = vec3_length(normal);
+    if (normal_length > 0.0f) normal = vec3_mul_float(normal, 1.0f / normal_length);
+
+    quadric_from_plane(q, normal, -vec3_dot(normal, p0), length * weight);
+}
+
+inline u32 hash_position(Vector3 position)
+{
+    u32 bits[3];
+    memcpy(bits, &position, sizeof(bits));
+
+    u32 h = bits[0] * 0x9e3779b1u;
+    h ^= bits[1] * 0x85ebca77u;
+    h ^= bits[2] * 0xc2b2ae3du;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+// remap points every vertex at the first one with the same position,
+// wedge links the vertices sharing a position in a ring
+static void build_position_remap(u32 *remap, u32 *wedge, Vertex *vertices, u32 num_vertices)
+{
+    u32 table_size = 1;
+    while (table_size < num_vertices * 2) table_size <<= 1;
+
+    u32 *table = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, table_size * sizeof(u32));
+    memset(table, 0xff, table_size * sizeof(u32));
+
+    for (u32 i = 0; i < num_vertices; i++) {
+        u32 slot = hash_position(vertices[i].position) & (table_size - 1);
+        for (;;) {
+            u32 other = table[slot];
+            if (other == NO_VERTEX) {
+                table[slot] = i;
+                remap[i] = i;
+                break;
+            }
+            if (memcmp(&vertices[other].position, &vertices[i].position, sizeof(Vector3)) == 0) {
+                remap[i] = other;
+                break;
+            }
+            slot = (slot + 1) & (table_size - 1);
+        }
+    }
+
+    deallocate(table);
+
+    for (u32 i = 0; i < num_vertices; i++)
+        wedge[i] = i;
+
+    for (u32 i = 0; i < num_vertices; i++) {
+        u32 r = remap[i];
+        if (r != i) {
+            wedge[i] = wedge[r];
+            wedge[r] = i;
+        }
+    }
+}
+
+static b32 has_edge(TriangleAdjacency *adjacency, u32 *indices, u32 a, u32 b)
+{
+    for (u32 i = adjacency->offsets[a]; i < adjacency->offsets[a + 1]; i++) {
+        u32 *triangle = indices + adjacency->triangles[i] * 3;
+        if ((triangle[0] == a && triangle[1] == b) || (triangle[1] == a && triangle[2] == b) || (triangle[2] == a && triangle[0] == b))
+            return true;
+    }
+    return false;
+}
+
+// loop and loopback follow open edges forwards and backwards, a vertex pointing at
+// itself has more than one
+static void classify_vertices(u8 *kind, u32 *loop, u32 *loopback, u32 *remap, u32 *wedge, u32 *indices, u32 num_indices, u32 num_vertices)
+{
+    TriangleAdjacency adjacency = build_triangle_adjacency(indices, num_indices, num_vertices);
+
+    memset(loop, 0xff, num_vertices * sizeof(u32));
+    memset(loopback, 0xff, num_vertices * sizeof(u32));
+
+    for (u32 i = 0; i < num_indices; i += 3) {
+        for (u32 e = 0; e < 3; e++) {
+            u32 a = indices[i + e];
+            u32 b = indices[i + (e + 1) % 3];
+            if (has_edge(&adjacency, indices, b, a)) continue;
+
+            loop[a] = (loop[a] == NO_VERTEX) ? b : a;
+            loopback[b] = (loopback[b] == NO_VERTEX) ? a : b;
+        }
+    }
+
+    free_triangle_adjacency(&adjacency);
+
+    for (u32 i = 0; i < num_vertices; i++) {
+        if (remap[i] != i) continue;
+
+        if (wedge[i] == i) {
+            if (loop[i] == NO_VERTEX && loopback[i] == NO_VERTEX)
+                kind[i] = VERTEX_KIND_MANIFOLD;
+            else if (loop[i] != NO_VERTEX && loopback[i] != NO_VERTEX && loop[i] != i && loopback[i] != i)
+                kind[i] = VERTEX_KIND_BORDER;
+            else
+                kind[i] = VERTEX_KIND_LOCKED;
+        } else if (wedge[wedge[i]] == i) {
+            // both wedges need one open edge each way and the two sides have to
+            // run between the same positions in opposite directions
+            u32 w = wedge[i];
+            b32 open = loop[i] != NO_VERTEX && loop[i] != i && loopback[i] != NO_VERTEX && loopback[i] != i &&
+                loop[w] != NO_VERTEX && loop[w] != w && loopback[w] != NO_VERTEX && loopback[w] != w;
+
+            if (open && remap[loopback[i]] == remap[loop[w]] && remap[loop[i]] == remap[loopback[w]] && remap[loop[i]] != remap[loopback[i]])
+                kind[i] = VERTEX_KIND_SEAM;
+            else
+                kind[i] = VERTEX_KIND_LOCKED;
+        } else {
+            kind[i] = VERTEX_KIND_LOCKED;
+        }
+    }
+
+    for (u32 i = 0; i < num_vertices; i++)
+        kind[i] = kind[remap[i]];
+}
+
+static void fill_quadrics(Quadric *quadrics, u32 *indices, u32 num_indices, Vector3 *positions, u8 *kind, u32 *loop, u32 *loopback, u32 *remap)
+{
+    for (u32 i = 0; i < num_indices; i += 3) {
+        Quadric q;
+        quadric_from_triangle(&q, positions[indices[i + 0]], positions[indices[i + 1]], positions[indices[i + 2]]);
+
+        for (u32 j = 0; j < 3; j++)
+            quadric_add(&quadrics[remap[indices[i + j]]], &q);
+    }
+
+    for (u32 i = 0; i < num_indices; i += 3) {
+        for (u32 e = 0; e < 3; e++) {
+            u32 i0 = indices[i + e];
+            u32 i1 = indices[i + (e + 1) % 3];
+            u32 i2 = indices[i + (e + 2) % 3];
+            u8 k0 = kind[i0], k1 = kind[i1];
+
+            b32 open0 = k0 == VERTEX_KIND_BORDER || k0 == VERTEX_KIND_SEAM;
+            b32 open1 = k1 == VERTEX_KIND_BORDER || k1 == VERTEX_KIND_SEAM;
+            if (!open0 && !open1) continue;
+            if (open0 && loop[i0] != i1) continue;
+            if (open1 && loopback[i1] != i0) continue;
+            if (has_opposite[k0][k1] && remap[i1] > remap[i0]) continue;
+
+            // seams are held in place by the collapse rules, they only need a light touch
+            f32 weight = (k0 == VERTEX_KIND_BORDER || k1 == VERTEX_KIND_BORDER) ? SIMPLIFY_BORDER_WEIGHT : 1.0f;
+
+            Quadric q;
+            quadric_from_triangle_edge(&q, positions[i0], positions[i1], positions[i2], weight);
+            quadric_add(&quadrics[remap[i0]], &q);
+            quadric_add(&quadrics[remap[i1]], &q);
+        }
+    }
+}
+
+static b32 has_triangle_flips(TriangleAdjacency *adjacency, u32 *indices, Vector3 *positions, u32 *collapse_remap, u32 i0, u32 i1)
+{
+    Vector3 v0 = positions[i0];
+    Vector3 v1 = positions[i1];
+
+    for (u32 i = adjacency->offsets[i0]; i < adjacency->offsets[i0 + 1]; i++) {
+        u32 *triangle = indices + adjacency->triangles[i] * 3;
+        u32 k = (triangle[0] == i0) ? 0 : (triangle[1] == i0) ? 1 : 2;
+        u32 a = collapse_remap[triangle[(k + 1) % 3]];
+        u32 b = collapse_remap[triangle[(k + 2) % 3]];
+
+        // this collapse or an earlier one removes the triangle anyway
+        if (a == i1 || b == i1 || a == b) continue;
+
+        Vector3 edge = vec3_sub(positions[b], positions[a]);
+        Vector3 n0 = vec3_cross(edge, vec3_sub(v0, positions[a]));
+        Vector3 n1 = vec3_cross(edge, vec3_sub(v1, positions[a]));
+        if (vec3_dot(n0, n1) <= 0.0f) return true;
+    }
+
+    return false;
+}
+
+static s32 compare_collapses(const void *a, const void *b)
+{
+    f32 cost_a = ((Collapse *)a)->cost;
+    f32 cost_b = ((Collapse *)b)->cost;
+    return (cost_a > cost_b) - (cost_a < cost_b);
+}
+
+static u32 pick_edge_collapses(Collapse *collapses, u32 *indices, u32 num_indices, u8 *kind, u32 *loop, u32 *remap)
+{
+    u32 num_collapses = 0;
+
+    for (u32 i = 0; i < num_indices; i += 3) {
+        for (u32 e = 0; e < 3; e++) {
+            u32 i0 = indices[i + e];
+            u32 i1 = indices[i + (e + 1) % 3];
+            if (remap[i0] == remap[i1]) continue;
+
+            u8 k0 = kind[i0], k1 = kind[i1];
+            if (!(can_collapse[k0][k1] | can_collapse[k1][k0])) continue;
+            if (has_opposite[k0][k1] && remap[i1] > remap[i0]) continue;
+
+            // two border or seam vertices without an open edge between them are on different loops
+            if (k0 == k1 && (k0 == VERTEX_KIND_BORDER || k0 == VERTEX_KIND_SEAM) && loop[i0] != i1) continue;
+
+            Collapse *collapse = &collapses[num_collapses++];
+            collapse->bidirectional = can_collapse[k0][k1] & can_collapse[k1][k0];
+            collapse->v0 = can_collapse[k0][k1] ? i0 : i1;
+            collapse->v1 = can_collapse[k0][k1] ? i1 : i0;
+        }
+    }
+
+    return num_collapses;
+}
+
+static void rank_edge_collapses(Collapse *collapses, u32 num_collapses, Quadric *quadrics, Vector3 *positions, Vertex *vertices, u32 *remap)
+{
+    for (u32 i = 0; i < num_collapses; i++) {
+        Collapse *collapse = &collapses[i];
+        u32 v0 = collapse->v0, v1 = collapse->v1;
+
+        f32 error = quadric_error(&quadrics[remap[v0]], positions[v1]);
+        f32 reverse_error = collapse->bidirectional ? quadric_error(&quadrics[remap[v1]], positions[v0]) : FLT_MAX;
+        if (reverse_error < error) {
+            collapse->v0 = v1;
+            collapse->v1 = v0;
+            error = reverse_error;
+        }
+
+        // the surviving vertex's attributes replace the collapsed one's
+        Vector3 normal_change = vec3_sub(vertices[v0].normal, vertices[v1].normal);
+        Vector2 texcoord_change = vec2_sub(vertices[v0].texcoord, vertices[v1].texcoord);
+
+        collapse->error = error;
+        collapse->cost = error + SIMPLIFY_NORMAL_WEIGHT * vec3_length_sq(normal_change) +
+            SIMPLIFY_TEXCOORD_WEIGHT * (texcoord_change.x * texcoord_change.x + texcoord_change.y * texcoord_change.y);
+    }
+}
+
+u32 simplify_mesh(u32 *destination, u32 *indices, u32 num_indices, Vertex *vertices, u32 num_vertices, u32 target_index_count, f32 *error)
+{
+    memcpy(destination, indices, num_indices * sizeof(u32));
+    u32 count = num_indices;
+    *error = 0.0f;
+
+    // work in a unit box so errors are relative to the mesh's size
+    AABB bounds = aabb_empty();
+    for (u32 i = 0; i < num_vertices; i++)
+        bounds = aabb_add_point(bounds, vertices[i].position);
+
+    Vector3 size = vec3_sub(bounds.max, bounds.min);
+    f32 extent = fmaxf(size.x, fmaxf(size.y, size.z));
+    f32 scale = (extent > 0.0f) ? 1.0f / extent : 1.0f;
+
+    Vector3 *positions = (Vector3 *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(Vector3));
+    for (u32 i = 0; i < num_vertices; i++)
+        positions[i] = vec3_mul_float(vec3_sub(vertices[i].position, bounds.min), scale);
+
+    u32 *remap = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u32));
+    u32 *wedge = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u32));
+    u32 *loop = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u32));
+    u32 *loopback = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u32));
+    u8 *kind = (u8 *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u8));
+
+    build_position_remap(remap, wedge, vertices, num_vertices);
+    classify_vertices(kind, loop, loopback, remap, wedge, destination, count, num_vertices);
+
+    Quadric *quadrics = (Quadric *)allocate_cleared(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(Quadric));
+    fill_quadrics(quadrics, destination, count, positions, kind, loop, loopback, remap);
+
+    Collapse *collapses = (Collapse *)allocate(MEMORY_TAG_MESH_BUILD, num_indices * sizeof(Collapse));
+    u32 *collapse_remap = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u32));
+    u8 *collapse_locked = (u8 *)allocate(MEMORY_TAG_MESH_BUILD, num_vertices * sizeof(u8));
+    f32 result_error = 0.0f;
+
+    while (count > target_index_count) {
+        u32 num_collapses = pick_edge_collapses(collapses, destination, count, kind, loop, remap);
+        if (!num_collapses) break;
+
+        rank_edge_collapses(collapses, num_collapses, quadrics, positions, vertices, remap);
+        qsort(collapses, num_collapses, sizeof(Collapse), compare_collapses);
+
+        for (u32 i = 0; i < num_vertices; i++)
+            collapse_remap[i] = i;
+        memset(collapse_locked, 0, num_vertices * sizeof(u8));
+
+        // a manifold collapse removes two triangles, stop the pass once the cheap
+        // half of what is left to do is used up so costs get refreshed
+        u32 triangle_collapse_goal = (count - target_index_count) / 3;
+        u32 edge_collapse_goal = triangle_collapse_goal / 2;
+        f32 cost_goal = (edge_collapse_goal < num_collapses) ? 1.5f * collapses[edge_collapse_goal].cost : FLT_MAX;
+
+        TriangleAdjacency adjacency = build_triangle_adjacency(destination, count, num_vertices);
+
+        u32 triangle_collapses = 0;
+        u32 performed = 0;
+        for (u32 i = 0; i < num_collapses; i++) {
+            Collapse *collapse = &collapses[i];
+            if (collapse->cost > cost_goal) break;
+
+            u32 i0 = collapse->v0, i1 = collapse->v1;
+            u32 r0 = remap[i0], r1 = remap[i1];
+
+            // each position moves at most once per pass
+            if (collapse_locked[r0] || collapse_locked[r1]) continue;
+            if (has_triangle_flips(&adjacency, destination, positions, collapse_remap, i0, i1)) continue;
+
+            // the other wedge of a seam follows along the other side of the seam
+            if (kind[i0] == VERTEX_KIND_SEAM) {
+                u32 s0 = wedge[i0];
+                u32 s1 = (loop[i0] == i1) ? loopback[s0] : loop[s0];
+                if (s1 == NO_VERTEX || s1 == s0 || remap[s1] != r1) continue;
+                if (has_triangle_flips(&adjacency, destination, positions, collapse_remap, s0, s1)) continue;
+
+                collapse_remap[s0] = s1;
+            }
+
+            collapse_remap[i0] = i1;
+            quadric_add(&quadrics[r1], &quadrics[r0]);
+
+            collapse_locked[r0] = true;
+            collapse_locked[r1] = true;
+
+            result_error = fmaxf(result_error, collapse->error);
+            triangle_collapses += (kind[i0] == VERTEX_KIND_BORDER) ? 1 : 2;
+            performed++;
+
+            if (triangle_collapses >= triangle_collapse_goal) break;
+        }
+
+        free_triangle_adjacency(&adjacency);
+
+        if (!performed) break;
+
+        // an open edge collapsed against its direction leaves the loop pointing at itself
+        for (u32 i = 0; i < num_vertices; i++) {
+            if (loop[i] != NO_VERTEX) {
+                u32 l = loop[i];
+                u32 r = collapse_remap[l];
+                loop[i] = (i == r) ? loop[l] : r;
+            }
+            if (loopback[i] != NO_VERTEX) {
+                u32 l = loopback[i];
+                u32 r = collapse_remap[l];
+                loopback[i] = (i == r) ? loopback[l] : r;
+            }
+        }
+
+        u32 write = 0;
+        for (u32 i = 0; i < count; i += 3) {
+            u32 a = collapse_remap[destination[i + 0]];
+            u32 b = collapse_remap[destination[i + 1]];
+            u32 c = collapse_remap[destination[i + 2]];
+            if (a == b || b == c || c == a) continue;
+
+            destination[write++] = a;
+            destination[write++] = b;
+            destination[write++] = c;
+        }
+        count = write;
+    }
+
+    *error = (f32)sqrt(result_error) * extent;
+
+    deallocate(collapse_locked);
+    deallocate(collapse_remap);
+    deallocate(collapses);
+    deallocate(quadrics);
+    deallocate(kind);
+    deallocate(loopback);
+    deallocate(loop);
+    deallocate(wedge);
+    deallocate(remap);
+    deallocate(positions);
+
+    return count;
+}
+
+// A level is every submesh simplified on its own, one after the other in submesh order, so
+// parts never merge across materials and the mesh's level covers them all. A submesh that
+// can't get any simpler repeats its previous level.
+void generate_mesh_lods(MemoryArena *arena, Mesh *mesh)
+{
+    u32 base_count = mesh->num_indices;
+
+    mesh->lods[0].index_offset = 0;
+    mesh->lods[0].index_count = base_count;
+    mesh->lods[0].error = 0.0f;
+    mesh->num_lods = 1;
+
+    // every level is simplified from the full mesh so errors don't stack up
+    u32 *scratch = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, base_count * sizeof(u32));
+    u32 *lod_indices = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, (MAX_MESH_LODS - 1) * base_count * sizeof(u32));
+    u32 lod_count = 0;
+
+    for (u32 i = 1; i < MAX_MESH_LODS; i++) {
+        u32 level_offset = lod_count;
+        f32 level_error = 0.0f;
+
+        for (u32 j = 0; j < mesh->num_submeshes; j++) {
+            Submesh *submesh = &mesh->submeshes[j];
+            MeshLod *base = &submesh->lods[0];
+            MeshLod *previous = &submesh->lods[i - 1];
+            u32 target = (base->index_count >> i) / 3 * 3;
+
+            f32 error;
+            u32 count = simplify_mesh(scratch, mesh->indices + base->index_offset, base->index_count, mesh->vertices, mesh->num_vertices, target, &error);
+            if (count == 0 || (f32)count > LOD_MIN_REDUCTION * (f32)previous->index_count) {
+                // the previous level's indices are either the full mesh or already in lod_indices
+                u32 *indices = (previous->index_offset < base_count) ? mesh->indices + previous->index_offset : lod_indices + (previous->index_offset - base_count);
+                count = previous->index_count;
+                error = previous->error;
+                memcpy(scratch, indices, count * sizeof(u32));
+            } else {
+                optimise_vertex_cache(scratch, count, mesh->num_vertices, VERTEX_CACHE_SIZE);
+            }
+
+            memcpy(lod_indices + lod_count, scratch, count * sizeof(u32));
+
+            MeshLod *lod = &submesh->lods[i];
+            lod->index_offset = base_count + lod_count;
+            lod->index_count = count;
+            lod->error = error;
+            lod_count += count;
+            level_error = fmaxf(level_error, error);
+        }
+
+        u32 level_count = lod_count - level_offset;
+        u32 previous = mesh->lods[mesh->num_lods - 1].index_count;
+        if (level_count == 0 || (f32)level_count > LOD_MIN_REDUCTION * (f32)previous) {
+            lod_count = level_offset;
+            break;
+        }
+
+        MeshLod *lod = &mesh->lods[mesh->num_lods++];
+        lod->index_offset = base_count + level_offset;
+        lod->index_count = level_count;
+        lod->error = level_error;
+    }
+
+    if (lod_count) {
+        assert((u8 *)(mesh->indices + base_count) == arena->base + arena->used);
+        u32 *levels = push_array_aligned(arena, lod_count, u32, sizeof(u32));
+        memcpy(levels, lod_indices, lod_count * sizeof(u32));
+        mesh->num_indices = base_count + lod_count;
+    }
+
+    deallocate(lod_indices);
+    deallocate(scratch);
+}
+
+u32 select_mesh_lod(Mesh *mesh, f32 distance, f32 pixels_per_unit)
+{
+    // the coarsest level that is still within a pixel or so of the full mesh
+    u32 result = 0;
+    for (u32 i = 1; i < mesh->num_lods; i++) {
+        if (mesh->lods[i].error * pixels_per_unit > LOD_PIXEL_ERROR * distance) break;
+        result = i;
+    }
+
+    return result;
+}
@@ -0,0 +1,30 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+// Each level aims for half the triangles of the one before, levels that can't
+// get below this fraction of the previous count end the chain.
+#define LOD_MIN_REDUCTION 0.9f
+
+// A level is used while its error projects to fewer pixels than this.
+#define LOD_PIXEL_ERROR 1.0f
+
+// Collapse ordering penalty for changing a vertex's normal or texcoord, in squared
+// distance relative to the mesh size. The reported error is geometric only.
+#define SIMPLIFY_NORMAL_WEIGHT 0.01f
+#define SIMPLIFY_TEXCOORD_WEIGHT 0.01f
+
+// Open edges get planes perpendicular to their triangle so borders hold their shape.
+#define SIMPLIFY_BORDER_WEIGHT 10.0f
+
+// Writes at most num_indices indices to destination and returns how many, error is the
+// object space distance the result may be off by.
+u32 simplify_mesh(u32 *destination, u32 *indices, u32 num_indices, Vertex *vertices, u32 num_vertices, u32 target_index_count, f32 *error);
+
+// The levels go on the end of mesh->indices in place, so the index array has to be the last
+// thing pushed on arena.
+void generate_mesh_lods(MemoryArena *arena, Mesh *mesh);
+
+// pixels_per_unit is how many pixels an object one unit across covers one unit from the camera
+u32 select_mesh_lod(Mesh *mesh, f32 distance, f32 pixels_per_unit);
+
+#endif /* MESH_SIMPLIFY_H */
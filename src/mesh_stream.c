@@ -0,0 +1,146 @@
+#include "mesh_stream.h"
+
+// A streamed mesh goes queued -> loading on the background thread -> loaded -> uploading
+// a budget's worth per frame -> resident. Only the state hands a staging slot between
+// the threads, everything else in it belongs to whoever the state says.
+
+void init_mesh_streamer(MeshStreamer *streamer, AssetRegistry *registry)
+{
+    memset(streamer, 0, sizeof(MeshStreamer));
+    streamer->registry = registry;
+
+    for (u32 i = 0; i < MESH_STAGING_SLOTS; i++)
+        reserve_scratch_arena(&streamer->staging[i].arena, MESH_STAGING_RESERVE_SIZE);
+}
+
+void release_mesh_streamer(MeshStreamer *streamer)
+{
+    for (u32 i = 0; i < MESH_STAGING_SLOTS; i++) {
+        MeshStaging *staging = &streamer->staging[i];
+        if (staging->state == MESH_STAGING_LOADED || staging->state == MESH_STAGING_UPLOADING)
+            free_mesh_upload(&staging->upload);
+        if (staging->arena.base) release_scratch_arena(&staging->arena);
+    }
+}
+
+// The slot's load is done with, a very large one doesn't keep its pages committed.
+static void free_staging(MeshStaging *staging)
+{
+    if (staging->arena.committed > MESH_STAGING_KEEP_SIZE) {
+        release_scratch_arena(&staging->arena);
+        reserve_scratch_arena(&staging->arena, MESH_STAGING_RESERVE_SIZE);
+    }
+    staging->state = MESH_STAGING_FREE;
+}
+
+MeshHandle stream_mesh(MeshStreamer *streamer, const char *file_name)
+{
+    u32 next_write = (streamer->pending_write + 1) % MAX_PENDING_MESH_STREAMS;
+    assert(next_write != streamer->pending_read);
+
+    MeshHandle mesh = { pool_alloc(&streamer->registry->meshes) };
+
+    PendingMeshStream *pending = &streamer->pending[streamer->pending_write];
+    snprintf(pending->file_name, sizeof(pending->file_name), "%s", file_name);
+    pending->target = mesh;
+    streamer->pending_write = next_write;
+
+    return mesh;
+}
+
+static PLATFORM_WORK_QUEUE_CALLBACK(load_staged_mesh_work)
+{
+    MeshStaging *staging = (MeshStaging *)data;
+
+    global_on_streaming_thread = true;
+    staging->mesh = load_mesh_data(&staging->arena, staging->file_name);
+    staging->upload = prepare_mesh_upload(staging->mesh);
+    global_on_streaming_thread = false;
+
+    // the mesh has to be visible before the main thread can see the new state
+    _WriteBarrier();
+    staging->state = MESH_STAGING_LOADED;
+}
+
+// Moves what drawing needs out of staging. The CPU side vertices and indices stay behind
+// and are gone once the slot loads another mesh, the pooled mesh has them as NULL.
+static void begin_staged_upload(MeshStreamer *streamer, MeshStaging *staging)
+{
+    // destroyed while it loaded, there's nothing to upload into
+    Mesh *mesh = lookup_mesh(streamer->registry, staging->target);
+    if (!mesh) {
+        free_mesh_upload(&staging->upload);
+        free_staging(staging);
+        return;
+    }
+
+    ShaderHandle shader = mesh->shader;
+    MaterialHandle material = mesh->material;
+
+    *mesh = *staging->mesh;
+    mesh->shader = shader;
+    mesh->material = material;
+    mesh->resident = false;
+    keep_mesh_draw_data(mesh);
+    resolve_mesh_materials(streamer->registry, mesh);
+
+    create_mesh_buffers(mesh, &staging->upload);
+    staging->uploaded = 0;
+    staging->state = MESH_STAGING_UPLOADING;
+}
+
+void update_mesh_streamer(MeshStreamer *streamer)
+{
+    for (u32 i = 0; i < MESH_STAGING_SLOTS; i++) {
+        MeshStaging *staging = &streamer->staging[i];
+        if (staging->state != MESH_STAGING_FREE || streamer->pending_read == streamer->pending_write)
+            continue;
+
+        PendingMeshStream *pending = &streamer->pending[streamer->pending_read];
+        streamer->pending_read = (streamer->pending_read + 1) % MAX_PENDING_MESH_STREAMS;
+
+        // destroyed before its turn, the slot can take the next one on a later frame
+        if (!lookup_mesh(streamer->registry, pending->target))
+            continue;
+
+        memcpy(staging->file_name, pending->file_name, sizeof(staging->file_name));
+        staging->target = pending->target;
+        reset_arena(&staging->arena);
+        staging->state = MESH_STAGING_LOADING;
+
+        // without a background thread the load has to happen here
+        if (global_platform->background_worker_count > 0)
+            global_platform->add_work_entry(global_platform->background_queue, load_staged_mesh_work, staging);
+        else
+            load_staged_mesh_work(NULL, staging);
+    }
+
+    u32 budget = (u32)MESH_UPLOAD_BUDGET;
+    for (u32 i = 0; i < MESH_STAGING_SLOTS && budget > 0; i++) {
+        MeshStaging *staging = &streamer->staging[i];
+
+        if (staging->state == MESH_STAGING_LOADED)
+            begin_staged_upload(streamer, staging);
+        if (staging->state != MESH_STAGING_UPLOADING)
+            continue;
+
+        Mesh *mesh = lookup_mesh(streamer->registry, staging->target);
+        if (!mesh) {
+            free_mesh_upload(&staging->upload);
+            free_staging(staging);
+            continue;
+        }
+
+        u32 total = staging->upload.vertex_size + staging->upload.index_size;
+        u32 size = (total - staging->uploaded < budget) ? total - staging->uploaded : budget;
+        upload_mesh_range(mesh, &staging->upload, staging->uploaded, size);
+        staging->uploaded += size;
+        budget -= size;
+
+        if (staging->uploaded == total) {
+            free_mesh_upload(&staging->upload);
+            mesh->resident = true;
+            free_staging(staging);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef MESH_STREAM_H
+#define MESH_STREAM_H
+
+// Meshes load one per staging slot, a second slot lets the next load run while the
+// last one uploads. Each slot is a range of its own that commits as the load grows, a
+// slot left holding more than MESH_STAGING_KEEP_SIZE gives its pages back once the
+// upload finishes.
+#define MESH_STAGING_SLOTS 2
+#define MESH_STAGING_RESERVE_SIZE gigabytes(16)
+#define MESH_STAGING_KEEP_SIZE megabytes(64)
+
+#define MAX_PENDING_MESH_STREAMS 64
+
+// Bytes of vertex and index data sent to the GPU per frame, at 60 fps this is 60 MB/s.
+#define MESH_UPLOAD_BUDGET megabytes(1)
+
+typedef enum MeshStagingState {
+    MESH_STAGING_FREE,
+    MESH_STAGING_LOADING, // owned by the streaming thread
+    MESH_STAGING_LOADED,
+    MESH_STAGING_UPLOADING
+} MeshStagingState;
+
+typedef struct MeshStaging {
+    u32 volatile state;
+
+    char file_name[512];
+    MeshHandle target;
+
+    // the streaming thread's arena, emptied once the upload finishes
+    MemoryArena arena;
+    Mesh *mesh;
+    MeshUpload upload;
+    u32 uploaded;
+} MeshStaging;
+
+typedef struct PendingMeshStream {
+    char file_name[512];
+    MeshHandle target;
+} PendingMeshStream;
+
+typedef struct MeshStreamer {
+    // meshes are copied out of staging into the registry's pool once loaded, their
+    // materials load through it
+    AssetRegistry *registry;
+
+    MeshStaging staging[MESH_STAGING_SLOTS];
+
+    PendingMeshStream pending[MAX_PENDING_MESH_STREAMS];
+    u32 pending_read, pending_write;
+} MeshStreamer;
+
+void init_mesh_streamer(MeshStreamer *streamer, AssetRegistry *registry);
+// Gives the staging slots back, for shutdown once the background queue is done.
+void release_mesh_streamer(MeshStreamer *streamer);
+
+// Returns the mesh straight away, it becomes resident on a later update_mesh_streamer.
+// The shader and material can be set on it before then. Destroying it before then
+// drops the load. A streamed mesh is only for drawing: its CPU side vertices and indices
+// stay in the staging slot, which the next load reuses.
+MeshHandle stream_mesh(MeshStreamer *streamer, const char *file_name);
+
+// Starts loads and uploads what fits in the frame's budget, main thread only.
+void update_mesh_streamer(MeshStreamer *streamer);
+
+#endif /* MESH_STREAM_H */
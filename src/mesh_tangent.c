@@ -0,0 +1,154 @@
+#include "mesh_tangent.h"
+
+// Two passes that each write only their own range, so neither needs locks. The first
+// finds every triangle's texture space directions, the second gathers them per vertex.
+
+typedef struct TriangleTangent {
+    Vector3 tangent; // unit direction of +u, zero when the texcoords are degenerate
+    f32 sign; // 1 when u, v and the normal form a right handed frame
+} TriangleTangent;
+
+typedef struct TangentChunk {
+    Mesh *mesh;
+    u8 *selected;
+    TriangleTangent *triangles;
+    TriangleAdjacency *adjacency;
+    u32 first, count;
+} TangentChunk;
+
+static void compute_triangle_tangents(TangentChunk *chunk)
+{
+    Mesh *mesh = chunk->mesh;
+
+    for (u32 i = chunk->first; i < chunk->first + chunk->count; i++) {
+        // only the selected vertices' triangles are ever gathered
+        u32 *corners = mesh->indices + i * 3;
+        if (chunk->selected && !chunk->selected[corners[0]] && !chunk->selected[corners[1]] && !chunk->selected[corners[2]])
+            continue;
+
+        Vertex *v0 = &mesh->vertices[corners[0]];
+        Vertex *v1 = &mesh->vertices[corners[1]];
+        Vertex *v2 = &mesh->vertices[corners[2]];
+
+        Vector3 e1 = vec3_sub(v1->position, v0->position);
+        Vector3 e2 = vec3_sub(v2->position, v0->position);
+        Vector2 d1 = vec2_sub(v1->texcoord, v0->texcoord);
+        Vector2 d2 = vec2_sub(v2->texcoord, v0->texcoord);
+
+        // twice the signed texture space area, its sign is the triangle's handedness
+        f32 area = d1.x * d2.y - d1.y * d2.x;
+        f32 sign = (area >= 0.0f) ? 1.0f : -1.0f;
+
+        Vector3 tangent = vec3_mul_float(vec3_sub(vec3_mul_float(e1, d2.y), vec3_mul_float(e2, d1.y)), sign);
+        f32 length = vec3_length(tangent);
+
+        TriangleTangent *triangle = &chunk->triangles[i];
+        triangle->tangent = (area != 0.0f && length > 0.0f) ? vec3_mul_float(tangent, 1.0f / length) : vec3(0.0f, 0.0f, 0.0f);
+        triangle->sign = sign;
+    }
+}
+
+// Any direction in the plane, for vertices whose triangles have no usable texcoords.
+inline Vector3 perpendicular(Vector3 n)
+{
+    Vector3 axis = (fabsf(n.x) < 0.9f) ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f);
+    return vec3_norm(vec3_cross(n, axis));
+}
+
+inline Vector3 project_onto_plane(Vector3 v, Vector3 n)
+{
+    return vec3_sub(v, vec3_mul_float(n, vec3_dot(n, v)));
+}
+
+static void gather_vertex_tangents(TangentChunk *chunk)
+{
+    Mesh *mesh = chunk->mesh;
+    TriangleAdjacency *adjacency = chunk->adjacency;
+
+    for (u32 vertex = chunk->first; vertex < chunk->first + chunk->count; vertex++) {
+        if (chunk->selected && !chunk->selected[vertex]) continue;
+
+        Vertex *v = &mesh->vertices[vertex];
+        Vector3 n = v->normal;
+
+        // MikkTSpace splits vertices whose triangles disagree on handedness, welded
+        // vertices can't be split here so the side with more angle wins
+        Vector3 sums[2] = { vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 0.0f) };
+        f32 weights[2] = { 0.0f, 0.0f };
+
+        for (u32 k = adjacency->offsets[vertex]; k < adjacency->offsets[vertex + 1]; k++) {
+            u32 triangle = adjacency->triangles[k];
+            TriangleTangent *t = &chunk->triangles[triangle];
+            if (vec3_length_sq(t->tangent) == 0.0f) continue;
+
+            u32 *corners = mesh->indices + triangle * 3;
+            u32 corner = (corners[0] == vertex) ? 0 : (corners[1] == vertex) ? 1 : 2;
+            Vector3 p0 = mesh->vertices[corners[corner]].position;
+            Vector3 p1 = mesh->vertices[corners[(corner + 1) % 3]].position;
+            Vector3 p2 = mesh->vertices[corners[(corner + 2) % 3]].position;
+
+            // the corner angle is measured in the normal's plane like MikkTSpace does
+            Vector3 a = project_onto_plane(vec3_sub(p1, p0), n);
+            Vector3 b = project_onto_plane(vec3_sub(p2, p0), n);
+            f32 lengths = vec3_length(a) * vec3_length(b);
+            if (lengths == 0.0f) continue;
+
+            f32 cosine = vec3_dot(a, b) / lengths;
+            f32 angle = (f32)acos(cosine < -1.0f ? -1.0f : (cosine > 1.0f ? 1.0f : cosine));
+
+            Vector3 tangent = project_onto_plane(t->tangent, n);
+            f32 length = vec3_length(tangent);
+            if (length == 0.0f) continue;
+
+            u32 side = (t->sign > 0.0f) ? 0 : 1;
+            sums[side] = vec3_add(sums[side], vec3_mul_float(tangent, angle / length));
+            weights[side] += angle;
+        }
+
+        u32 side = (weights[1] > weights[0]) ? 1 : 0;
+        f32 length = vec3_length(sums[side]);
+        Vector3 tangent = (length > 0.0f) ? vec3_mul_float(sums[side], 1.0f / length) : perpendicular(n);
+
+        v->tangent = vec4(tangent.x, tangent.y, tangent.z, side ? -1.0f : 1.0f);
+    }
+}
+
+static PLATFORM_WORK_QUEUE_CALLBACK(compute_triangle_tangents_work) { compute_triangle_tangents((TangentChunk *)data); }
+static PLATFORM_WORK_QUEUE_CALLBACK(gather_vertex_tangents_work) { gather_vertex_tangents((TangentChunk *)data); }
+
+static void run_tangent_chunks(PlatformWorkQueueCallback *callback, TangentChunk *chunks, u32 num_chunks, u32 total)
+{
+    for (u32 i = 0; i < num_chunks; i++) {
+        chunks[i].first = (u32)get_chunk_start(total, i, num_chunks);
+        chunks[i].count = (u32)get_chunk_start(total, i + 1, num_chunks) - chunks[i].first;
+    }
+
+    run_chunks(callback, chunks, sizeof(TangentChunk), num_chunks);
+}
+
+void generate_tangents(Mesh *mesh, u8 *selected)
+{
+    u32 num_triangles = mesh->num_indices / 3;
+    if (num_triangles == 0) return;
+
+    TriangleTangent *triangles = (TriangleTangent *)allocate(MEMORY_TAG_MESH_BUILD, num_triangles * sizeof(TriangleTangent));
+    TriangleAdjacency adjacency = build_triangle_adjacency(mesh->indices, mesh->num_indices, mesh->num_vertices);
+
+    u32 num_chunks = TANGENT_CHUNKS_PER_THREAD * (get_worker_count() + 1);
+    if (num_chunks > TANGENT_MAX_CHUNKS) num_chunks = TANGENT_MAX_CHUNKS;
+    if (num_chunks > num_triangles) num_chunks = num_triangles;
+
+    TangentChunk chunks[TANGENT_MAX_CHUNKS];
+    for (u32 i = 0; i < num_chunks; i++) {
+        chunks[i].mesh = mesh;
+        chunks[i].selected = selected;
+        chunks[i].triangles = triangles;
+        chunks[i].adjacency = &adjacency;
+    }
+
+    run_tangent_chunks(compute_triangle_tangents_work, chunks, num_chunks, num_triangles);
+    run_tangent_chunks(gather_vertex_tangents_work, chunks, num_chunks, mesh->num_vertices);
+
+    free_triangle_adjacency(&adjacency);
+    deallocate(triangles);
+}
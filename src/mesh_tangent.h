@@ -0,0 +1,15 @@
+#ifndef MESH_TANGENT_H
+#define MESH_TANGENT_H
+
+// Triangles are split into this many per thread so uneven adjacency still balances.
+#define TANGENT_CHUNKS_PER_THREAD 4
+#define TANGENT_MAX_CHUNKS 256
+
+// Fills vertex tangents the way MikkTSpace does, so normal maps baked against it light
+// correctly: per triangle tangents are projected into each vertex's normal plane and
+// weighted by the corner angle, w holds the sign to build the bitangent with
+// bitangent = w * cross(normal, tangent). Only the vertices marked in selected are
+// written, NULL selects them all.
+void generate_tangents(Mesh *mesh, u8 *selected);
+
+#endif /* MESH_TANGENT_H */
@@ -0,0 +1,337 @@
+#include "meshlet.h"
+
+// Meshlets grow from a seed triangle into its neighbours and the index buffer is
+// rewritten meshlet by meshlet, so each one is just a range of it. Culling a meshlet
+// means drawing the ranges around it.
+
+// Ritter's sphere, start from the most distant pair of axis extremes and grow to fit the rest.
+static Sphere compute_bounding_sphere(Vector3 *points, u32 count)
+{
+    u32 min_point[3] = { 0 }, max_point[3] = { 0 };
+    for (u32 i = 0; i < count; i++) {
+        for (u32 axis = 0; axis < 3; axis++) {
+            if (points[i].elements[axis] < points[min_point[axis]].elements[axis]) min_point[axis] = i;
+            if (points[i].elements[axis] > points[max_point[axis]].elements[axis]) max_point[axis] = i;
+        }
+    }
+
+    u32 widest = 0;
+    f32 widest_distance = -1.0f;
+    for (u32 axis = 0; axis < 3; axis++) {
+        f32 distance = vec3_length_sq(vec3_sub(points[max_point[axis]], points[min_point[axis]]));
+        if (distance > widest_distance) {
+            widest_distance = distance;
+            widest = axis;
+        }
+    }
+
+    Sphere sphere;
+    sphere.centre = vec3_mul_float(vec3_add(points[min_point[widest]], points[max_point[widest]]), 0.5f);
+    sphere.radius = (f32)sqrt(widest_distance) * 0.5f;
+
+    for (u32 i = 0; i < count; i++) {
+        f32 distance = vec3_length(vec3_sub(points[i], sphere.centre));
+        if (distance > sphere.radius) {
+            f32 radius = (sphere.radius + distance) * 0.5f;
+            sphere.centre = vec3_add(sphere.centre, vec3_mul_float(vec3_sub(points[i], sphere.centre), (radius - sphere.radius) / distance));
+            sphere.radius = radius;
+        }
+    }
+
+    return sphere;
+}
+
+// The cone axis is the average triangle normal and the cutoff comes from the widest normal.
+// The apex is pushed back along the axis until it is behind every triangle's plane, from
+// there the test stays conservative for cameras close to the meshlet.
+static void compute_meshlet_cone(Meshlet *meshlet, Mesh *mesh)
+{
+    Vector3 normals[MESHLET_MAX_TRIANGLES];
+    u32 num_triangles = meshlet->index_count / 3;
+    u32 *indices = mesh->indices + meshlet->index_offset;
+
+    Vector3 axis = vec3(0.0f, 0.0f, 0.0f);
+    for (u32 i = 0; i < num_triangles; i++) {
+        Vector3 p0 = mesh->vertices[indices[i * 3 + 0]].position;
+        Vector3 p1 = mesh->vertices[indices[i * 3 + 1]].position;
+        Vector3 p2 = mesh->vertices[indices[i * 3 + 2]].position;
+
+        Vector3 normal = vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0));
+        f32 length = vec3_length(normal);
+        normals[i] = (length > 0.0f) ? vec3_mul_float(normal, 1.0f / length) : normal;
+        axis = vec3_add(axis, normals[i]);
+    }
+
+    // a cutoff of one never culls
+    meshlet->cone_apex = meshlet->bounds.centre;
+    meshlet->cone_axis = vec3(0.0f, 0.0f, 1.0f);
+    meshlet->cone_cutoff = 1.0f;
+
+    f32 axis_length = vec3_length(axis);
+    if (axis_length == 0.0f) return;
+    axis = vec3_mul_float(axis, 1.0f / axis_length);
+
+    f32 min_dot = 1.0f;
+    for (u32 i = 0; i < num_triangles; i++) {
+        if (vec3_length_sq(normals[i]) == 0.0f) continue;
+        min_dot = fminf(min_dot, vec3_dot(axis, normals[i]));
+    }
+
+    // wider than ~84 degrees, only a handful of view directions could ever cull it
+    if (min_dot <= 0.1f) return;
+
+    f32 max_t = 0.0f;
+    for (u32 i = 0; i < num_triangles; i++) {
+        if (vec3_length_sq(normals[i]) == 0.0f) continue;
+
+        Vector3 p0 = mesh->vertices[indices[i * 3]].position;
+        f32 t = vec3_dot(vec3_sub(meshlet->bounds.centre, p0), normals[i]) / vec3_dot(axis, normals[i]);
+        max_t = fmaxf(max_t, t);
+    }
+
+    meshlet->cone_apex = vec3_sub(meshlet->bounds.centre, vec3_mul_float(axis, max_t));
+    meshlet->cone_axis = axis;
+    meshlet->cone_cutoff = (f32)sqrt(1.0f - min_dot * min_dot);
+}
+
+// Builds the meshlets of one submesh's range, meshlets never cross submeshes so culling
+// one can't skip another part's triangles. vertex_meshlet tags are meshlet numbers across
+// the whole mesh, output is indexed like mesh->indices.
+static void build_submesh_meshlets(Mesh *mesh, MeshLod *range, Vector3 *normals, Meshlet *meshlets, u32 *num_meshlets, u32 *vertex_meshlet, u32 *output)
+{
+    u32 num_triangles = range->index_count / 3;
+    if (num_triangles == 0) return;
+
+    u32 *indices = mesh->indices + range->index_offset;
+    TriangleAdjacency adjacency = build_triangle_adjacency(indices, range->index_count, mesh->num_vertices);
+    u8 *emitted = (u8 *)allocate_cleared(MEMORY_TAG_MESH_BUILD, num_triangles * sizeof(u8));
+
+    u32 meshlet_vertices[MESHLET_MAX_VERTICES];
+    Vector3 points[MESHLET_MAX_VERTICES];
+    u32 output_count = 0;
+    u32 seed = 0;
+
+    while (output_count < range->index_count) {
+        // seeds follow the optimised order so consecutive meshlets stay close together
+        while (emitted[seed]) seed++;
+
+        Meshlet *meshlet = &meshlets[(*num_meshlets)++];
+        meshlet->index_offset = range->index_offset + output_count;
+        meshlet->index_count = 0;
+
+        // vertices are tagged with the meshlet that last used them
+        u32 tag = *num_meshlets;
+        u32 num_points = 0;
+        Vector3 axis = vec3(0.0f, 0.0f, 0.0f);
+        u32 triangle = seed;
+
+        while (triangle != 0xffffffff) {
+            for (u32 j = 0; j < 3; j++) {
+                u32 vertex = indices[triangle * 3 + j];
+                if (vertex_meshlet[vertex] != tag) {
+                    vertex_meshlet[vertex] = tag;
+                    meshlet_vertices[num_points] = vertex;
+                    points[num_points++] = mesh->vertices[vertex].position;
+                }
+                output[range->index_offset + output_count++] = vertex;
+            }
+            meshlet->index_count += 3;
+            emitted[triangle] = true;
+            axis = vec3_add(axis, normals[triangle]);
+
+            if (meshlet->index_count == MESHLET_MAX_TRIANGLES * 3) break;
+
+            // grow into the neighbour that adds the fewest vertices, ties go to the one
+            // that keeps the normal cone tightest
+            f32 axis_length = vec3_length(axis);
+            Vector3 cone_axis = (axis_length > 0.0f) ? vec3_mul_float(axis, 1.0f / axis_length) : axis;
+
+            f32 best_score = FLT_MAX;
+            triangle = 0xffffffff;
+            for (u32 i = 0; i < num_points; i++) {
+                u32 vertex = meshlet_vertices[i];
+                for (u32 k = adjacency.offsets[vertex]; k < adjacency.offsets[vertex + 1]; k++) {
+                    u32 candidate = adjacency.triangles[k];
+                    if (emitted[candidate]) continue;
+
+                    u32 *corners = indices + candidate * 3;
+                    u32 new_vertices = 0;
+                    for (u32 j = 0; j < 3; j++) {
+                        b32 repeated = (j > 0 && corners[j] == corners[0]) || (j > 1 && corners[j] == corners[1]);
+                        if (vertex_meshlet[corners[j]] != tag && !repeated) new_vertices++;
+                    }
+                    if (num_points + new_vertices > MESHLET_MAX_VERTICES) continue;
+
+                    f32 score = (f32)new_vertices + (1.0f - vec3_dot(normals[candidate], cone_axis)) * MESHLET_CONE_WEIGHT;
+                    if (score < best_score) {
+                        best_score = score;
+                        triangle = candidate;
+                    }
+                }
+            }
+
+            // nothing connected fits, carry on with the next triangle in the optimised order
+            // as long as it faces roughly the same way, loose triangles would ruin the cone
+            if (triangle == 0xffffffff) {
+                while (seed < num_triangles && emitted[seed]) seed++;
+                if (seed < num_triangles) {
+                    u32 *corners = indices + seed * 3;
+                    u32 new_vertices = 0;
+                    for (u32 j = 0; j < 3; j++) {
+                        b32 repeated = (j > 0 && corners[j] == corners[0]) || (j > 1 && corners[j] == corners[1]);
+                        if (vertex_meshlet[corners[j]] != tag && !repeated) new_vertices++;
+                    }
+                    if (num_points + new_vertices <= MESHLET_MAX_VERTICES && vec3_dot(normals[seed], cone_axis) > 0.8f)
+                        triangle = seed;
+                }
+            }
+        }
+
+        meshlet->bounds = compute_bounding_sphere(points, num_points);
+    }
+    assert(output_count == range->index_count);
+
+    deallocate(emitted);
+    free_triangle_adjacency(&adjacency);
+}
+
+// Growing meshlets throws away the cache order optimise_mesh gave the triangles, so each
+// meshlet's are put back in cache order. The meshlet's vertices are numbered from zero for
+// it, vertex_local is all 0xffffffff going in and coming out.
+static void optimise_meshlet_cache(Mesh *mesh, Meshlet *meshlet, u32 *vertex_local)
+{
+    u32 local[MESHLET_MAX_TRIANGLES * 3];
+    u32 vertices[MESHLET_MAX_VERTICES];
+    u32 num_vertices = 0;
+
+    u32 *indices = mesh->indices + meshlet->index_offset;
+    for (u32 i = 0; i < meshlet->index_count; i++) {
+        u32 vertex = indices[i];
+        if (vertex_local[vertex] == 0xffffffff) {
+            vertex_local[vertex] = num_vertices;
+            vertices[num_vertices++] = vertex;
+        }
+        local[i] = vertex_local[vertex];
+    }
+
+    optimise_vertex_cache(local, meshlet->index_count, num_vertices, VERTEX_CACHE_SIZE);
+
+    for (u32 i = 0; i < meshlet->index_count; i++)
+        indices[i] = vertices[local[i]];
+    for (u32 i = 0; i < num_vertices; i++)
+        vertex_local[vertices[i]] = 0xffffffff;
+}
+
+void build_meshlets(MemoryArena *arena, Mesh *mesh)
+{
+    mesh->meshlets = NULL;
+    mesh->num_meshlets = 0;
+
+    // the simplified levels after level 0 don't get meshlets
+    u32 num_indices = mesh->lods[0].index_count;
+    u32 num_triangles = num_indices / 3;
+    if (num_triangles == 0) return;
+
+    Vector3 *normals = (Vector3 *)allocate(MEMORY_TAG_MESH_BUILD, num_triangles * sizeof(Vector3));
+    for (u32 i = 0; i < num_triangles; i++) {
+        Vector3 p0 = mesh->vertices[mesh->indices[i * 3 + 0]].position;
+        Vector3 p1 = mesh->vertices[mesh->indices[i * 3 + 1]].position;
+        Vector3 p2 = mesh->vertices[mesh->indices[i * 3 + 2]].position;
+
+        Vector3 normal = vec3_cross(vec3_sub(p1, p0), vec3_sub(p2, p0));
+        f32 length = vec3_length(normal);
+        normals[i] = (length > 0.0f) ? vec3_mul_float(normal, 1.0f / length) : normal;
+    }
+
+    // one triangle each is the worst case, the real count is copied into the arena at the end
+    Meshlet *meshlets = (Meshlet *)allocate(MEMORY_TAG_MESH_BUILD, num_triangles * sizeof(Meshlet));
+    u32 *vertex_meshlet = (u32 *)allocate_cleared(MEMORY_TAG_MESH_BUILD, mesh->num_vertices * sizeof(u32));
+    u32 *output = (u32 *)allocate(MEMORY_TAG_MESH_BUILD, num_indices * sizeof(u32));
+    u32 num_meshlets = 0;
+
+    for (u32 i = 0; i < mesh->num_submeshes; i++) {
+        Submesh *submesh = &mesh->submeshes[i];
+        MeshLod *range = &submesh->lods[0];
+
+        submesh->meshlet_offset = num_meshlets;
+        build_submesh_meshlets(mesh, range, normals + range->index_offset / 3, meshlets, &num_meshlets, vertex_meshlet, output);
+        submesh->meshlet_count = num_meshlets - submesh->meshlet_offset;
+    }
+
+    // meshlets are contiguous ranges of the new order
+    memcpy(mesh->indices, output, num_indices * sizeof(u32));
+    if (OPTIMISE_MESHES) {
+        memset(vertex_meshlet, 0xff, mesh->num_vertices * sizeof(u32));
+        for (u32 i = 0; i < num_meshlets; i++)
+            optimise_meshlet_cache(mesh, &meshlets[i], vertex_meshlet);
+    }
+    for (u32 i = 0; i < num_meshlets; i++)
+        compute_meshlet_cone(&meshlets[i], mesh);
+
+    mesh->num_meshlets = num_meshlets;
+    mesh->meshlets = push_array(arena, num_meshlets, Meshlet);
+    memcpy(mesh->meshlets, meshlets, num_meshlets * sizeof(Meshlet));
+
+    deallocate(output);
+    deallocate(vertex_meshlet);
+    deallocate(meshlets);
+    deallocate(normals);
+}
+
+u32 draw_meshlets(MemoryArena *frame_arena, Mesh *mesh, u32 first, u32 count, Frustum *frustum, Vector3 camera_position)
+{
+    usize index_size = (mesh->index_type == GL_UNSIGNED_SHORT) ? sizeof(u16) : sizeof(u32);
+
+    // neighbouring visible meshlets merge into one range, a mostly visible mesh is still a few draws
+    GLsizei *counts = push_array(frame_arena, count, GLsizei);
+    const void **offsets = push_array(frame_arena, count, const void *);
+    u32 num_ranges = 0;
+    u32 num_culled = 0;
+
+    u8 *results = NULL;
+    if (frustum) {
+        Vector3Array centres = push_vector3_array(frame_arena, count);
+        f32 *radii = push_array(frame_arena, lane_count(count), f32);
+        for (u32 i = 0; i < lane_count(count); i++) {
+            Sphere bounds = (i < count) ? mesh->meshlets[first + i].bounds : (Sphere){ 0 };
+            centres.x[i] = bounds.centre.x;
+            centres.y[i] = bounds.centre.y;
+            centres.z[i] = bounds.centre.z;
+            radii[i] = bounds.radius;
+        }
+
+        results = push_array(frame_arena, lane_count(count), u8);
+        cull_spheres(frustum, centres, radii, count, results);
+    }
+
+    for (u32 i = first; i < first + count; i++) {
+        Meshlet *meshlet = &mesh->meshlets[i];
+
+        b32 visible = !results || results[i - first] != CULL_OUTSIDE;
+        if (visible) {
+            Vector3 view = vec3_sub(meshlet->cone_apex, camera_position);
+            if (vec3_dot(view, meshlet->cone_axis) > meshlet->cone_cutoff * vec3_length(view))
+                visible = false;
+        }
+
+        if (!visible) {
+            num_culled++;
+            continue;
+        }
+
+        usize offset = meshlet->index_offset * index_size;
+        if (num_ranges && (usize)offsets[num_ranges - 1] + counts[num_ranges - 1] * index_size == offset) {
+            counts[num_ranges - 1] += (GLsizei)meshlet->index_count;
+            continue;
+        }
+
+        counts[num_ranges] = (GLsizei)meshlet->index_count;
+        offsets[num_ranges] = (const void *)offset;
+        num_ranges++;
+    }
+
+    if (num_ranges)
+        glMultiDrawElements(GL_TRIANGLES, counts, mesh->index_type, offsets, (GLsizei)num_ranges);
+
+    return num_culled;
+}
@@ -0,0 +1,18 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+// Limits match what mesh shader hardware likes, so the same clusters work if we ever get there.
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+// How much a triangle's normal straying from the meshlet's counts against it, in new vertices.
+#define MESHLET_CONE_WEIGHT 0.5f
+
+void build_meshlets(MemoryArena *arena, Mesh *mesh);
+
+// Draws meshlets first up to first + count, frustum and camera_position are in the mesh's
+// model space, a null frustum only cone culls. Returns how many meshlets were culled, the
+// draw list goes in frame_arena.
+u32 draw_meshlets(MemoryArena *frame_arena, Mesh *mesh, u32 first, u32 count, Frustum *frustum, Vector3 camera_position);
+
+#endif /* MESHLET_H */
@@ -1,6 +1,6 @@
 #include "opengl.h"
 
-Shader *load_shader(MemoryArena *arena, const char *vertex_source, const char *fragment_source)
+Shader load_shader(const char *vertex_source, const char *fragment_source)
 {
     GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertex_shader, 1, &vertex_source, NULL);
@@ -34,21 +34,20 @@ Shader *load_shader(MemoryArena *arena, const char *vertex_source, const char *f
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
 
-    Shader *shader = push_struct(arena, Shader);
-    shader->id = program;
+    Shader shader = { program };
 
     return shader;
 }
 
-Shader *load_shader_from_file(MemoryArena *arena, const char *vertex_file, const char *fragment_file)
+Shader load_shader_from_file(const char *vertex_file, const char *fragment_file)
 {
     char *vertex_source = read_file(vertex_file);
     char *fragment_source = read_file(fragment_file);
 
-    Shader *shader = load_shader(arena, vertex_source, fragment_source);
+    Shader shader = load_shader(vertex_source, fragment_source);
 
-    free(vertex_source);
-    free(fragment_source);
+    deallocate(vertex_source);
+    deallocate(fragment_source);
 
     return shader;
 }
@@ -95,51 +94,91 @@ void set_uniform_mat4(GLuint shader_id, const char *name, Matrix4x4 m)
     glUniformMatrix4fv(location, 1, GL_FALSE, m.item);
 }
 
-Texture *load_texture(MemoryArena *arena, const char *file_name)
+// What GL keeps for a texture, drivers pad RGB to four components. Mipmaps add a third.
+static u32 get_texture_size(GLenum internal_format, s32 width, s32 height, u32 faces, b32 mipmapped)
 {
+    u32 texel_size = 4;
+    if (internal_format == GL_RGB16F) texel_size = 8;
+    else if (internal_format == GL_RGB32F || internal_format == GL_RGBA32F) texel_size = 16;
+
+    u32 size = (u32)width * (u32)height * texel_size * faces;
+    return mipmapped ? size + size / 3 : size;
+}
+
+// A single magenta texel stands in for images that are missing or can't be decoded.
+static u32 upload_missing_texture(void)
+{
+    u8 magenta[4] = { 255, 0, 255, 255 };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, magenta);
+
+    return get_texture_size(GL_RGBA, 1, 1, 1, false);
+}
+
+Texture load_texture_from_memory(u8 *memory, u32 size, b32 flip)
+{
+    Texture texture = { 0 };
     GLuint id;
     glGenTextures(1, &id);
     glBindTexture(GL_TEXTURE_2D, id);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    if (stbi_is_hdr(file_name)) {
+    if (!memory) {
+        texture.size = upload_missing_texture();
+    } else if (stbi_is_hdr_from_memory(memory, (s32)size)) {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
         s32 width, height, channels;
-        stbi_set_flip_vertically_on_load(true);
-        u8 *data = (u8*)stbi_loadf(file_name, &width, &height, &channels, 0);
-
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGB, GL_FLOAT, data);
+        stbi_set_flip_vertically_on_load(flip);
+        u8 *data = (u8*)stbi_loadf_from_memory(memory, (s32)size, &width, &height, &channels, 0);
+        if (data) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGB, GL_FLOAT, data);
+            texture.size = get_texture_size(GL_RGBA32F, width, height, 1, false);
+        } else {
+            printf("HDR image couldn't be decoded: %s\n", stbi_failure_reason());
+            texture.size = upload_missing_texture();
+        }
         stbi_image_free(data);
     } else {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
         s32 width, height, channels;
-        stbi_set_flip_vertically_on_load(true);
-        u8 *data = stbi_load(file_name, &width, &height, &channels, 0);
+        stbi_set_flip_vertically_on_load(flip);
+        u8 *data = stbi_load_from_memory(memory, (s32)size, &width, &height, &channels, 0);
         if (data) {
             if (channels == 3)
                 glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
             else if (channels == 4)
                 glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            if (channels == 3 || channels == 4) texture.size = get_texture_size(GL_RGBA, width, height, 1, false);
         } else {
-            assert(false);
-            // log error
+            printf("image couldn't be decoded: %s\n", stbi_failure_reason());
+            texture.size = upload_missing_texture();
         }
         stbi_image_free(data);
     }
 
-    Texture *texture = push_struct(arena, Texture);
-    texture->id = id;
+    texture.id = id;
 
     return texture;
 }
 
-Texture *load_cubemap(MemoryArena *arena, const char *file_name)
+Texture load_texture(const char *file_name)
+{
+    // a missing file gets the missing texture
+    MappedFile file = map_file(file_name);
+    if (!file.data) printf("%s: file not found\n", file_name);
+
+    Texture texture = load_texture_from_memory(file.data, (u32)file.size, true);
+    unmap_file(&file);
+
+    return texture;
+}
+
+Texture load_cubemap(const char *file_name)
 {
     // sort this out
     const char *cube_map[6];
@@ -173,13 +212,12 @@ Texture *load_cubemap(MemoryArena *arena, const char *file_name)
         stbi_image_free(data);
     }
 
-    Texture *texture = push_struct(arena, Texture);
-    texture->id = id;
+    Texture texture = { id, get_texture_size(GL_RGB, width, height, 6, false) };
 
     return texture;
 }
 
-Texture *generate_texture_cubemap(MemoryArena *arena, const char *file_name)
+TextureHandle generate_texture_cubemap(AssetRegistry *registry, const char *file_name)
 {
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
     s32 size = 512;
@@ -192,12 +230,13 @@ Texture *generate_texture_cubemap(MemoryArena *arena, const char *file_name)
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffer);
 
-    Texture *cubemap = push_struct(arena, Texture);
-    glGenTextures(1, &cubemap->id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap->id);
+    Texture cubemap = { 0 };
+    glGenTextures(1, &cubemap.id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap.id);
     for (u32 i = 0; i < 6; i++) {
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB32F, size, size, 0, GL_RGB, GL_FLOAT, NULL);
     }
+    cubemap.size = get_texture_size(GL_RGB32F, size, size, 6, false);
 
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -215,31 +254,33 @@ Texture *generate_texture_cubemap(MemoryArena *arena, const char *file_name)
         mat4_lookat(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, -1.0f, 0.0f))
     };
 
-    Shader *shader = load_shader_from_file(arena, "../assets/shaders/cubemap_vertex.glsl", "../assets/shaders/cubemap_fragment.glsl");
-    Texture *texture = load_texture(arena, file_name);
+    Shader *shader = lookup_shader(registry, get_shader(registry, "../assets/shaders/cubemap_vertex.glsl", "../assets/shaders/cubemap_fragment.glsl"));
+    Texture *texture = lookup_texture(registry, get_texture(registry, file_name));
 
     glUseProgram(shader->id);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, texture->id);
     set_uniform_mat4(shader->id, "projection", framebuffer_projection);
 
+    Mesh *cube = lookup_mesh(registry, load_cube(registry));
+    set_mesh_uniforms(shader->id, cube);
+    glBindVertexArray(cube->vertex_array);
+
     glViewport(0, 0, size, size);
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 
     for (s32 i = 0; i < 6; i++) {
         set_uniform_mat4(shader->id, "view", framebuffer_view[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubemap->id, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubemap.id, 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        Mesh *cube = load_cube(arena);
-        glBindVertexArray(cube->vertex_array);
-        glDrawElements(GL_TRIANGLES, cube->num_indices, GL_UNSIGNED_INT, 0);
+        draw_mesh_lod(cube, 0);
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    return cubemap;
+    return add_texture(registry, cubemap);
 }
 
-Texture *generate_texture_irradiance(MemoryArena *arena, Texture *cubemap)
+TextureHandle generate_texture_irradiance(AssetRegistry *registry, TextureHandle cubemap)
 {
     s32 size = 32;
 
@@ -251,12 +292,13 @@ Texture *generate_texture_irradiance(MemoryArena *arena, Texture *cubemap)
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffer);
 
-    Texture *irradiance = push_struct(arena, Texture);
-    glGenTextures(1, &irradiance->id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, irradiance->id);
+    Texture irradiance = { 0 };
+    glGenTextures(1, &irradiance.id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, irradiance.id);
     for (u32 i = 0; i < 6; i++) {
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, size, size, 0, GL_RGB, GL_FLOAT, NULL);
     }
+    irradiance.size = get_texture_size(GL_RGB16F, size, size, 6, false);
 
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -274,30 +316,32 @@ Texture *generate_texture_irradiance(MemoryArena *arena, Texture *cubemap)
         mat4_lookat(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, -1.0f, 0.0f))
     };
 
-    Shader *shader = load_shader_from_file(arena, "../assets/shaders/irradiance_vertex.glsl", "../assets/shaders/irradiance_fragment.glsl");
+    Shader *shader = lookup_shader(registry, get_shader(registry, "../assets/shaders/irradiance_vertex.glsl", "../assets/shaders/irradiance_fragment.glsl"));
 
     glUseProgram(shader->id);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap->id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, lookup_texture(registry, cubemap)->id);
     set_uniform_mat4(shader->id, "projection", framebuffer_projection);
 
+    Mesh *cube = lookup_mesh(registry, load_cube(registry));
+    set_mesh_uniforms(shader->id, cube);
+    glBindVertexArray(cube->vertex_array);
+
     glViewport(0, 0, size, size);
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 
     for (s32 i = 0; i < 6; i++) {
         set_uniform_mat4(shader->id, "view", framebuffer_view[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradiance->id, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradiance.id, 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        Mesh *cube = load_cube(arena);
-        glBindVertexArray(cube->vertex_array);
-        glDrawElements(GL_TRIANGLES, cube->num_indices, GL_UNSIGNED_INT, 0);
+        draw_mesh_lod(cube, 0);
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    return irradiance;
+    return add_texture(registry, irradiance);
 }
 
-Texture *generate_texture_prefilter(MemoryArena *arena, Texture *cubemap)
+TextureHandle generate_texture_prefilter(AssetRegistry *registry, TextureHandle cubemap)
 {
     s32 size = 256;
 
@@ -309,12 +353,13 @@ Texture *generate_texture_prefilter(MemoryArena *arena, Texture *cubemap)
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffer);
 
-    Texture *prefilter = push_struct(arena, Texture);
-    glGenTextures(1, &prefilter->id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, prefilter->id);
+    Texture prefilter = { 0 };
+    glGenTextures(1, &prefilter.id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, prefilter.id);
     for (u32 i = 0; i < 6; i++) {
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, size, size, 0, GL_RGB, GL_FLOAT, NULL);
     }
+    prefilter.size = get_texture_size(GL_RGB16F, size, size, 6, true);
 
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -334,13 +379,17 @@ Texture *generate_texture_prefilter(MemoryArena *arena, Texture *cubemap)
         mat4_lookat(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, -1.0f, 0.0f))
     };
 
-    Shader *shader = load_shader_from_file(arena, "../assets/shaders/prefilter_vertex.glsl", "../assets/shaders/prefilter_fragment.glsl");
+    Shader *shader = lookup_shader(registry, get_shader(registry, "../assets/shaders/prefilter_vertex.glsl", "../assets/shaders/prefilter_fragment.glsl"));
 
     glUseProgram(shader->id);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap->id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, lookup_texture(registry, cubemap)->id);
     set_uniform_mat4(shader->id, "projection", framebuffer_projection);
 
+    Mesh *cube = lookup_mesh(registry, load_cube(registry));
+    set_mesh_uniforms(shader->id, cube);
+    glBindVertexArray(cube->vertex_array);
+
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 
     s32 MAX_MIPMAP_LEVELS = 5;
@@ -358,26 +407,25 @@ Texture *generate_texture_prefilter(MemoryArena *arena, Texture *cubemap)
 
         for (s32 i = 0; i < 6; i++) {
             set_uniform_mat4(shader->id, "view", framebuffer_view[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilter->id, mip);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilter.id, mip);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            Mesh *cube = load_cube(arena);
-            glBindVertexArray(cube->vertex_array);
-            glDrawElements(GL_TRIANGLES, cube->num_indices, GL_UNSIGNED_INT, 0);
+            draw_mesh_lod(cube, 0);
         }
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    return prefilter;
+    return add_texture(registry, prefilter);
 }
 
-Texture *generate_texture_brdf(MemoryArena *arena)
+TextureHandle generate_texture_brdf(AssetRegistry *registry)
 {
     s32 size = 512;
 
-    Texture *brdf = push_struct(arena, Texture);
-    glGenTextures(1, &brdf->id);
-    glBindTexture(GL_TEXTURE_2D, brdf->id);
+    Texture brdf = { 0 };
+    glGenTextures(1, &brdf.id);
+    glBindTexture(GL_TEXTURE_2D, brdf.id);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, size, size, 0, GL_RGB, GL_FLOAT, NULL);
+    brdf.size = get_texture_size(GL_RGB32F, size, size, 1, false);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -391,9 +439,9 @@ Texture *generate_texture_brdf(MemoryArena *arena)
     glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffer);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdf->id, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdf.id, 0);
 
-    Shader *shader = load_shader_from_file(arena, "../assets/shaders/brdf_vertex.glsl", "../assets/shaders/brdf_fragment.glsl");
+    Shader *shader = lookup_shader(registry, get_shader(registry, "../assets/shaders/brdf_vertex.glsl", "../assets/shaders/brdf_fragment.glsl"));
 
     glViewport(0, 0, size, size);
     glUseProgram(shader->id);
@@ -402,11 +450,5 @@ Texture *generate_texture_brdf(MemoryArena *arena)
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    return brdf;
+    return add_texture(registry, brdf);
 }
-
-void generate_enviroment_maps(MemoryArena *arena, const char *file_name, Texture *cubemap, Texture *irradiance, Texture *prefilter, Texture *brdf)
-{
-}
-
-
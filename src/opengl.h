@@ -20,10 +20,21 @@ typedef struct Shader {
 
 typedef struct Texture {
     GLuint id;
+    u32 size; // bytes GL keeps for it, for the memory stats
 } Texture;
 
-Shader *load_shader(MemoryArena *arena, const char *vertex_source, const char *fragment_source);
-Shader *load_shader_from_file(MemoryArena *arena, const char *vertex_file, const char *fragment_file);
+// Shaders and textures live in the asset registry's pools, everything else refers to them
+// by these. Separate types so one can't be passed for the other.
+typedef struct ShaderHandle {
+    u32 value;
+} ShaderHandle;
+
+typedef struct TextureHandle {
+    u32 value;
+} TextureHandle;
+
+Shader load_shader(const char *vertex_source, const char *fragment_source);
+Shader load_shader_from_file(const char *vertex_file, const char *fragment_file);
 
 void set_uniform_int(GLuint shader_id, const char *name, s32 value);
 void set_uniform_float(GLuint shader_id, const char *name, f32 value);
@@ -33,8 +44,9 @@ void set_uniform_vec4(GLuint shader_id, const char *name, Vector4 v);
 void set_uniform_mat3(GLuint shader_id, const char *name, Matrix3x3 m);
 void set_uniform_mat4(GLuint shader_id, const char *name, Matrix4x4 m);
 
-Texture *load_texture(MemoryArena *arena, const char *file_name);
-Texture *load_cubemap(MemoryArena *arena, const char *file_name);
-void generate_enviroment_maps(MemoryArena *arena, const char *file_name, Texture *cubemap, Texture *irradiance, Texture *prefilter, Texture *brdf);
+Texture load_texture(const char *file_name);
+// An encoded image already in memory, flip for files whose texcoords start bottom left.
+Texture load_texture_from_memory(u8 *memory, u32 size, b32 flip);
+Texture load_cubemap(const char *file_name);
 
 #endif /* OPENGL_H */
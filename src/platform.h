@@ -100,9 +100,25 @@ typedef struct InputState {
     Vector2 position;
 } InputState;
 
+typedef struct PlatformWorkQueue PlatformWorkQueue;
+
+#define PLATFORM_WORK_QUEUE_CALLBACK(name) void name(PlatformWorkQueue *queue, void *data)
+typedef PLATFORM_WORK_QUEUE_CALLBACK(PlatformWorkQueueCallback);
+
 typedef struct Platform {
+    // Only reserved, pages have to go through commit_memory before they're touched. Large
+    // page arenas come committed since that's the only way the OS hands them out.
     usize permanent_arena_size;
     void *permanent_arena;
+    b32 permanent_arena_committed;
+
+    // memory and size needn't be page aligned, every page they touch is committed
+    b32 (*commit_memory)(void *memory, usize size);
+
+    // Address space of its own for scratch that only lives through one load, committed
+    // with commit_memory. Release takes back the whole range, committed or not.
+    void *(*reserve_memory)(usize size);
+    void (*release_memory)(void *memory, usize size);
 
     b32 running;
     b32 initialised;
@@ -115,12 +131,30 @@ typedef struct Platform {
 
     f32 frames_per_second;
 
+    // filled in by the game each frame, shown after the frame time in the window title
+    char frame_info[64];
+
     u64 ticks_per_second;
     u64 start_ticks;
     u64 end_ticks;
 
     void *(*load_opengl_function)(char *name);
     void (*swap_buffers)(void);
+
+    // work is only added from the main thread, complete_all_work also runs entries on the caller
+    PlatformWorkQueue *work_queue;
+    u32 worker_count;
+
+    // long running jobs like streaming loads, nothing waits on this queue during a frame
+    PlatformWorkQueue *background_queue;
+    u32 background_worker_count;
+
+    // the chunks of a streaming load's parallel stages, only the background job adds to it
+    // and waits on it so it never holds up the main thread's queue
+    PlatformWorkQueue *stream_queue;
+    u32 stream_worker_count;
+    void (*add_work_entry)(PlatformWorkQueue *queue, PlatformWorkQueueCallback *callback, void *data);
+    void (*complete_all_work)(PlatformWorkQueue *queue);
 } Platform;
 
 #endif /* PLATFORM_H */
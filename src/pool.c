@@ -0,0 +1,62 @@
+#include "pool.h"
+
+void init_pool(Pool *pool, MemoryArena *arena, u32 capacity, u32 item_size)
+{
+    assert(capacity > 0 && capacity <= MAX_POOL_CAPACITY);
+    assert(item_size >= sizeof(u32)); // free slots keep the free list in the item
+
+    memset(pool, 0, sizeof(Pool));
+    pool->item_size = item_size;
+    pool->capacity = capacity;
+    pool->items = (u8 *)push_memory(arena, (usize)capacity * item_size);
+    pool->generations = push_array(arena, capacity, u16);
+}
+
+inline u32 make_pool_handle(u32 index, u16 generation)
+{
+    return ((u32)generation << POOL_INDEX_BITS) | index;
+}
+
+u32 pool_alloc(Pool *pool)
+{
+    u32 index;
+    if (pool->free_head) {
+        index = pool->free_head - 1;
+        pool->free_head = *(u32 *)(pool->items + (usize)index * pool->item_size);
+    } else {
+        assert(pool->used < pool->capacity);
+        index = pool->used++;
+        pool->generations[index] = 1;
+    }
+    pool->count++;
+
+    memset(pool->items + (usize)index * pool->item_size, 0, pool->item_size);
+
+    return make_pool_handle(index, pool->generations[index]);
+}
+
+void *pool_get(Pool *pool, u32 handle)
+{
+    u32 index = handle & POOL_INDEX_MASK;
+    u16 generation = (u16)(handle >> POOL_INDEX_BITS);
+    if (!handle || index >= pool->used || pool->generations[index] != generation) return NULL;
+
+    return pool->items + (usize)index * pool->item_size;
+}
+
+b32 pool_free(Pool *pool, u32 handle)
+{
+    u8 *item = (u8 *)pool_get(pool, handle);
+    if (!item) return false;
+
+    // generations wrap past 0, a handle kept through 65535 reuses of its slot resolves again
+    u32 index = handle & POOL_INDEX_MASK;
+    pool->generations[index]++;
+    if (!pool->generations[index]) pool->generations[index] = 1;
+
+    *(u32 *)item = pool->free_head;
+    pool->free_head = index + 1;
+    pool->count--;
+
+    return true;
+}
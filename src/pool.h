@@ -0,0 +1,32 @@
+#ifndef POOL_H
+#define POOL_H
+
+// Fixed size pools of one type addressed by handles rather than pointers. A handle is the
+// slot index in the low bits and the slot's generation in the high bits. Freeing a slot
+// bumps its generation, so handles to what used to be there stop resolving instead of
+// pointing at whatever reused the slot. 0 is never a valid handle.
+#define POOL_INDEX_BITS 16
+#define POOL_INDEX_MASK ((1u << POOL_INDEX_BITS) - 1)
+#define MAX_POOL_CAPACITY (1u << POOL_INDEX_BITS)
+
+typedef struct Pool {
+    u8 *items;
+    u16 *generations; // of each slot, never 0
+    u32 item_size;
+    u32 capacity;
+
+    u32 used;      // slots handed out at least once
+    u32 free_head; // index + 1 of the last freed slot, each free slot holds the next in its first bytes
+    u32 count;     // live items
+} Pool;
+
+void init_pool(Pool *pool, MemoryArena *arena, u32 capacity, u32 item_size);
+
+// The new item is zeroed, asserts when the pool is full.
+u32 pool_alloc(Pool *pool);
+// NULL for 0 and for handles whose slot was freed since.
+void *pool_get(Pool *pool, u32 handle);
+// Returns false if the handle was already stale.
+b32 pool_free(Pool *pool, u32 handle);
+
+#endif /* POOL_H */
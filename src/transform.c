@@ -0,0 +1,308 @@
+#include "transform.h"
+
+// A matrix with a different object in every lane, m[column][row] like Matrix4x4.
+typedef struct LaneMatrix {
+    lane_f32 m[4][4];
+} LaneMatrix;
+
+typedef struct TransformChunk {
+    TransformBatch *batch;
+    TransformResults *results;
+    Matrix4x4 *view_projection;
+    u32 first, end;
+} TransformChunk;
+
+Vector3Array push_vector3_array(MemoryArena *arena, u32 count)
+{
+    u32 padded = lane_count(count);
+
+    Vector3Array result;
+    result.x = push_array(arena, padded, f32);
+    result.y = push_array(arena, padded, f32);
+    result.z = push_array(arena, padded, f32);
+
+    // the padding goes through the kernels too, keep it to numbers
+    for (u32 i = count; i < padded; i++) result.x[i] = result.y[i] = result.z[i] = 0.0f;
+
+    return result;
+}
+
+void init_transform_batch(TransformBatch *batch, MemoryArena *arena, u32 capacity)
+{
+    u32 padded = lane_count(capacity);
+
+    batch->count = 0;
+    batch->capacity = capacity;
+
+    batch->positions = push_vector3_array(arena, padded);
+    batch->rotations.x = push_array(arena, padded, f32);
+    batch->rotations.y = push_array(arena, padded, f32);
+    batch->rotations.z = push_array(arena, padded, f32);
+    batch->rotations.w = push_array(arena, padded, f32);
+    batch->scales = push_vector3_array(arena, padded);
+    batch->bounds_centres = push_vector3_array(arena, padded);
+    batch->bounds_extents = push_vector3_array(arena, padded);
+
+    for (u32 i = 0; i < padded; i++) {
+        set_transform(batch, i, vec3(0.0f, 0.0f, 0.0f), (Quaternion){ 0.0f, 0.0f, 0.0f, 1.0f }, vec3(1.0f, 1.0f, 1.0f));
+        set_transform_bounds(batch, i, (AABB){ 0 });
+    }
+}
+
+u32 add_transform(TransformBatch *batch, Vector3 position, Quaternion rotation, Vector3 scale)
+{
+    assert(batch->count < batch->capacity);
+
+    u32 index = batch->count++;
+    set_transform(batch, index, position, rotation, scale);
+    set_transform_bounds(batch, index, (AABB){ 0 });
+
+    return index;
+}
+
+void set_transform(TransformBatch *batch, u32 index, Vector3 position, Quaternion rotation, Vector3 scale)
+{
+    batch->positions.x[index] = position.x;
+    batch->positions.y[index] = position.y;
+    batch->positions.z[index] = position.z;
+
+    batch->rotations.x[index] = rotation.x;
+    batch->rotations.y[index] = rotation.y;
+    batch->rotations.z[index] = rotation.z;
+    batch->rotations.w[index] = rotation.w;
+
+    batch->scales.x[index] = scale.x;
+    batch->scales.y[index] = scale.y;
+    batch->scales.z[index] = scale.z;
+}
+
+void set_transform_bounds(TransformBatch *batch, u32 index, AABB bounds)
+{
+    Vector3 centre = aabb_centre(bounds);
+    Vector3 extents = aabb_extents(bounds);
+
+    batch->bounds_centres.x[index] = centre.x;
+    batch->bounds_centres.y[index] = centre.y;
+    batch->bounds_centres.z[index] = centre.z;
+    batch->bounds_extents.x[index] = extents.x;
+    batch->bounds_extents.y[index] = extents.y;
+    batch->bounds_extents.z[index] = extents.z;
+}
+
+inline LaneMatrix broadcast_matrix(Matrix4x4 *m)
+{
+    LaneMatrix result;
+    for (u32 i = 0; i < 4; i++) {
+        for (u32 j = 0; j < 4; j++)
+            result.m[i][j] = lane_set1(m->elements[i][j]);
+    }
+    return result;
+}
+
+// the points and boxes are in the xyz of the matrix's first three columns, w is 1
+inline void transform_point_lanes(LaneMatrix *m, lane_f32 *x, lane_f32 *y, lane_f32 *z)
+{
+    lane_f32 px = *x, py = *y, pz = *z;
+    *x = lane_mul_add(m->m[0][0], px, lane_mul_add(m->m[1][0], py, lane_mul_add(m->m[2][0], pz, m->m[3][0])));
+    *y = lane_mul_add(m->m[0][1], px, lane_mul_add(m->m[1][1], py, lane_mul_add(m->m[2][1], pz, m->m[3][1])));
+    *z = lane_mul_add(m->m[0][2], px, lane_mul_add(m->m[1][2], py, lane_mul_add(m->m[2][2], pz, m->m[3][2])));
+}
+
+// Arvo, the extents of the new box are the old ones through the absolute matrix
+inline void transform_extents_lanes(LaneMatrix *m, lane_f32 *x, lane_f32 *y, lane_f32 *z)
+{
+    lane_f32 ex = *x, ey = *y, ez = *z;
+    *x = lane_mul_add(lane_abs(m->m[0][0]), ex, lane_mul_add(lane_abs(m->m[1][0]), ey, lane_mul(lane_abs(m->m[2][0]), ez)));
+    *y = lane_mul_add(lane_abs(m->m[0][1]), ex, lane_mul_add(lane_abs(m->m[1][1]), ey, lane_mul(lane_abs(m->m[2][1]), ez)));
+    *z = lane_mul_add(lane_abs(m->m[0][2]), ex, lane_mul_add(lane_abs(m->m[1][2]), ey, lane_mul(lane_abs(m->m[2][2]), ez)));
+}
+
+// quat_to_mat4 with the columns scaled and the translation in the last
+static LaneMatrix get_world_lanes(TransformBatch *batch, u32 first)
+{
+    lane_f32 qx = lane_load(batch->rotations.x + first);
+    lane_f32 qy = lane_load(batch->rotations.y + first);
+    lane_f32 qz = lane_load(batch->rotations.z + first);
+    lane_f32 qw = lane_load(batch->rotations.w + first);
+
+    lane_f32 two = lane_set1(2.0f);
+    lane_f32 xx = lane_mul(qx, qx), yy = lane_mul(qy, qy), zz = lane_mul(qz, qz);
+    lane_f32 xy = lane_mul(qx, qy), xz = lane_mul(qx, qz), yz = lane_mul(qy, qz);
+    lane_f32 wx = lane_mul(qw, qx), wy = lane_mul(qw, qy), wz = lane_mul(qw, qz);
+
+    lane_f32 sx = lane_load(batch->scales.x + first);
+    lane_f32 sy = lane_load(batch->scales.y + first);
+    lane_f32 sz = lane_load(batch->scales.z + first);
+
+    lane_f32 one = lane_set1(1.0f);
+    lane_f32 zero = lane_set1(0.0f);
+
+    LaneMatrix result;
+    result.m[0][0] = lane_mul(lane_sub(one, lane_mul(two, lane_add(yy, zz))), sx);
+    result.m[0][1] = lane_mul(lane_mul(two, lane_add(xy, wz)), sx);
+    result.m[0][2] = lane_mul(lane_mul(two, lane_sub(xz, wy)), sx);
+    result.m[0][3] = zero;
+
+    result.m[1][0] = lane_mul(lane_mul(two, lane_sub(xy, wz)), sy);
+    result.m[1][1] = lane_mul(lane_sub(one, lane_mul(two, lane_add(xx, zz))), sy);
+    result.m[1][2] = lane_mul(lane_mul(two, lane_add(yz, wx)), sy);
+    result.m[1][3] = zero;
+
+    result.m[2][0] = lane_mul(lane_mul(two, lane_add(xz, wy)), sz);
+    result.m[2][1] = lane_mul(lane_mul(two, lane_sub(yz, wx)), sz);
+    result.m[2][2] = lane_mul(lane_sub(one, lane_mul(two, lane_add(xx, yy))), sz);
+    result.m[2][3] = zero;
+
+    result.m[3][0] = lane_load(batch->positions.x + first);
+    result.m[3][1] = lane_load(batch->positions.y + first);
+    result.m[3][2] = lane_load(batch->positions.z + first);
+    result.m[3][3] = one;
+
+    return result;
+}
+
+// the lanes go out one object at a time, only count of them are real
+static void store_matrix_lanes(LaneMatrix *m, Matrix4x4 *out, u32 count)
+{
+    f32 elements[16][LANE_WIDTH];
+    for (u32 i = 0; i < 16; i++)
+        lane_store(elements[i], m->m[i / 4][i % 4]);
+
+    for (u32 lane = 0; lane < count; lane++) {
+        for (u32 i = 0; i < 16; i++)
+            out[lane].item[i] = elements[i][lane];
+    }
+}
+
+static void store_normal_lanes(LaneMatrix *m, Matrix3x3 *out, u32 count)
+{
+    f32 elements[9][LANE_WIDTH];
+    for (u32 i = 0; i < 9; i++)
+        lane_store(elements[i], m->m[i / 3][i % 3]);
+
+    for (u32 lane = 0; lane < count; lane++) {
+        for (u32 i = 0; i < 9; i++)
+            out[lane].item[i] = elements[i][lane];
+    }
+}
+
+static void compute_transform_chunk(TransformChunk *chunk)
+{
+    TransformBatch *batch = chunk->batch;
+    TransformResults *results = chunk->results;
+    LaneMatrix view_projection = broadcast_matrix(chunk->view_projection);
+
+    for (u32 i = chunk->first; i < chunk->end; i += LANE_WIDTH) {
+        LaneMatrix world = get_world_lanes(batch, i);
+
+        // every column of the product is view_projection's columns weighted by world's
+        LaneMatrix mvp;
+        for (u32 column = 0; column < 4; column++) {
+            for (u32 row = 0; row < 4; row++) {
+                lane_f32 sum = lane_mul(view_projection.m[0][row], world.m[column][0]);
+                sum = lane_mul_add(view_projection.m[1][row], world.m[column][1], sum);
+                sum = lane_mul_add(view_projection.m[2][row], world.m[column][2], sum);
+                sum = lane_mul_add(view_projection.m[3][row], world.m[column][3], sum);
+                mvp.m[column][row] = sum;
+            }
+        }
+
+        // world is rotate * scale, so transpose(inverse()) of it is rotate / scale, which is
+        // the columns of world divided by their scale twice
+        LaneMatrix normal;
+        lane_f32 one = lane_set1(1.0f);
+        lane_f32 scales[3] = { lane_load(batch->scales.x + i), lane_load(batch->scales.y + i), lane_load(batch->scales.z + i) };
+        for (u32 column = 0; column < 3; column++) {
+            lane_f32 inverse_scale_sq = lane_div(one, lane_mul(scales[column], scales[column]));
+            for (u32 row = 0; row < 3; row++)
+                normal.m[column][row] = lane_mul(world.m[column][row], inverse_scale_sq);
+        }
+
+        u32 count = (chunk->end - i < LANE_WIDTH) ? chunk->end - i : LANE_WIDTH;
+        store_matrix_lanes(&world, results->world + i, count);
+        store_matrix_lanes(&mvp, results->mvp + i, count);
+        store_normal_lanes(&normal, results->normal + i, count);
+
+        lane_f32 cx = lane_load(batch->bounds_centres.x + i);
+        lane_f32 cy = lane_load(batch->bounds_centres.y + i);
+        lane_f32 cz = lane_load(batch->bounds_centres.z + i);
+        transform_point_lanes(&world, &cx, &cy, &cz);
+        lane_store(results->bounds_centres.x + i, cx);
+        lane_store(results->bounds_centres.y + i, cy);
+        lane_store(results->bounds_centres.z + i, cz);
+
+        lane_f32 ex = lane_load(batch->bounds_extents.x + i);
+        lane_f32 ey = lane_load(batch->bounds_extents.y + i);
+        lane_f32 ez = lane_load(batch->bounds_extents.z + i);
+        transform_extents_lanes(&world, &ex, &ey, &ez);
+        lane_store(results->bounds_extents.x + i, ex);
+        lane_store(results->bounds_extents.y + i, ey);
+        lane_store(results->bounds_extents.z + i, ez);
+    }
+}
+
+static PLATFORM_WORK_QUEUE_CALLBACK(compute_transform_chunk_work) { compute_transform_chunk((TransformChunk *)data); }
+
+TransformResults compute_transforms(MemoryArena *arena, TransformBatch *batch, Matrix4x4 view_projection)
+{
+    TransformResults results;
+    results.count = batch->count;
+    results.world = push_array(arena, batch->count, Matrix4x4);
+    results.mvp = push_array(arena, batch->count, Matrix4x4);
+    results.normal = push_array(arena, batch->count, Matrix3x3);
+    results.bounds_centres = push_vector3_array(arena, batch->count);
+    results.bounds_extents = push_vector3_array(arena, batch->count);
+
+    // chunks start on whole lanes so no two write the same padded lane
+    u32 num_lanes = lane_count(batch->count) / LANE_WIDTH;
+    u32 num_chunks = TRANSFORM_CHUNKS_PER_THREAD * (get_worker_count() + 1);
+    if (num_chunks > TRANSFORM_MAX_CHUNKS) num_chunks = TRANSFORM_MAX_CHUNKS;
+    if (num_chunks > batch->count / TRANSFORM_MIN_CHUNK_SIZE) num_chunks = batch->count / TRANSFORM_MIN_CHUNK_SIZE;
+    if (num_chunks < 1) num_chunks = 1;
+
+    TransformChunk chunks[TRANSFORM_MAX_CHUNKS];
+    for (u32 i = 0; i < num_chunks; i++) {
+        chunks[i].batch = batch;
+        chunks[i].results = &results;
+        chunks[i].view_projection = &view_projection;
+        chunks[i].first = (u32)get_chunk_start(num_lanes, i, num_chunks) * LANE_WIDTH;
+        chunks[i].end = (u32)get_chunk_start(num_lanes, i + 1, num_chunks) * LANE_WIDTH;
+        if (chunks[i].end > batch->count) chunks[i].end = batch->count;
+    }
+
+    run_chunks(compute_transform_chunk_work, chunks, sizeof(TransformChunk), num_chunks);
+
+    return results;
+}
+
+void transform_points(Matrix4x4 m, Vector3Array points, u32 count, Vector3Array results)
+{
+    LaneMatrix lanes = broadcast_matrix(&m);
+
+    for (u32 i = 0; i < count; i += LANE_WIDTH) {
+        lane_f32 x = lane_load(points.x + i);
+        lane_f32 y = lane_load(points.y + i);
+        lane_f32 z = lane_load(points.z + i);
+        transform_point_lanes(&lanes, &x, &y, &z);
+        lane_store(results.x + i, x);
+        lane_store(results.y + i, y);
+        lane_store(results.z + i, z);
+    }
+}
+
+void transform_bounds(Matrix4x4 m, Vector3Array centres, Vector3Array extents, u32 count, Vector3Array result_centres, Vector3Array result_extents)
+{
+    transform_points(m, centres, count, result_centres);
+
+    LaneMatrix lanes = broadcast_matrix(&m);
+
+    for (u32 i = 0; i < count; i += LANE_WIDTH) {
+        lane_f32 x = lane_load(extents.x + i);
+        lane_f32 y = lane_load(extents.y + i);
+        lane_f32 z = lane_load(extents.z + i);
+        transform_extents_lanes(&lanes, &x, &y, &z);
+        lane_store(result_extents.x + i, x);
+        lane_store(result_extents.y + i, y);
+        lane_store(result_extents.z + i, z);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+// Big batches are split over the work queue, a chunk is at least this many objects.
+#define TRANSFORM_CHUNKS_PER_THREAD 2
+#define TRANSFORM_MAX_CHUNKS 64
+#define TRANSFORM_MIN_CHUNK_SIZE 256
+
+// Structure of arrays, one float per object in each, padded to whole lanes.
+typedef struct Vector3Array {
+    f32 *x, *y, *z;
+} Vector3Array;
+
+typedef struct QuaternionArray {
+    f32 *x, *y, *z, *w;
+} QuaternionArray;
+
+// Objects are translated, rotated and scaled, world = translate * rotate * scale, the
+// rotations have to be unit quaternions. The bounds are the local space box each object's
+// mesh has.
+typedef struct TransformBatch {
+    u32 count;
+    u32 capacity;
+
+    Vector3Array positions;
+    QuaternionArray rotations;
+    Vector3Array scales;
+
+    // centres and half extents
+    Vector3Array bounds_centres;
+    Vector3Array bounds_extents;
+} TransformBatch;
+
+// What a batch comes out as for one view, count entries of each. The world space bounds
+// are the boxes around the transformed local ones.
+typedef struct TransformResults {
+    u32 count;
+    Matrix4x4 *world;
+    Matrix4x4 *mvp;
+    Matrix3x3 *normal; // mat4_normal_matrix of world
+
+    Vector3Array bounds_centres;
+    Vector3Array bounds_extents;
+} TransformResults;
+
+Vector3Array push_vector3_array(MemoryArena *arena, u32 count);
+
+void init_transform_batch(TransformBatch *batch, MemoryArena *arena, u32 capacity);
+u32 add_transform(TransformBatch *batch, Vector3 position, Quaternion rotation, Vector3 scale);
+void set_transform(TransformBatch *batch, u32 index, Vector3 position, Quaternion rotation, Vector3 scale);
+void set_transform_bounds(TransformBatch *batch, u32 index, AABB bounds);
+
+// World, model view projection and normal matrices and world bounds of every object in
+// the batch, pushed on arena.
+TransformResults compute_transforms(MemoryArena *arena, TransformBatch *batch, Matrix4x4 view_projection);
+
+// The same m for every point or box. The arrays are padded to whole lanes, results can be
+// the arrays the points came from.
+void transform_points(Matrix4x4 m, Vector3Array points, u32 count, Vector3Array results);
+void transform_bounds(Matrix4x4 m, Vector3Array centres, Vector3Array extents, u32 count, Vector3Array result_centres, Vector3Array result_extents);
+
+#endif /* TRANSFORM_H */
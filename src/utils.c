@@ -12,7 +12,7 @@ char *read_file(const char *file_name)
     u32 length = ftell(file);
     rewind(file);
 
-    data = (char*)malloc(sizeof(char) * (length+1));
+    data = (char*)allocate(MEMORY_TAG_FILE, sizeof(char) * (length+1));
     fread(data, sizeof(char), length, file);
     data[length] = '\0';
 
@@ -20,3 +20,67 @@ char *read_file(const char *file_name)
 
     return data;
 }
+
+FileInfo get_file_info(const char *file_name)
+{
+    FileInfo info = { 0 };
+
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (GetFileAttributesExA(file_name, GetFileExInfoStandard, &data)) {
+        info.exists = true;
+        info.size = ((u64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+        info.write_time = ((u64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+    }
+
+    return info;
+}
+
+MappedFile map_file(const char *file_name)
+{
+    MappedFile mapped_file = { 0 };
+
+    HANDLE file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return mapped_file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        // empty files can't be mapped
+        CloseHandle(file);
+        return mapped_file;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        return mapped_file;
+    }
+
+    mapped_file.data = (u8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!mapped_file.data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return mapped_file;
+    }
+
+    mapped_file.size = (usize)size.QuadPart;
+    mapped_file.file_handle = file;
+    mapped_file.mapping_handle = mapping;
+
+    return mapped_file;
+}
+
+void unmap_file(MappedFile *mapped_file)
+{
+    if (mapped_file->data)
+        UnmapViewOfFile(mapped_file->data);
+    if (mapped_file->mapping_handle)
+        CloseHandle((HANDLE)mapped_file->mapping_handle);
+    if (mapped_file->file_handle)
+        CloseHandle((HANDLE)mapped_file->file_handle);
+
+    mapped_file->data = NULL;
+    mapped_file->size = 0;
+    mapped_file->file_handle = NULL;
+    mapped_file->mapping_handle = NULL;
+}
@@ -1,6 +1,25 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+typedef struct MappedFile {
+    u8 *data;
+    usize size;
+
+    void *file_handle;
+    void *mapping_handle;
+} MappedFile;
+
+typedef struct FileInfo {
+    b32 exists;
+    u64 size;
+    u64 write_time;
+} FileInfo;
+
+// free with deallocate
 char *read_file(const char *file_name);
+FileInfo get_file_info(const char *file_name);
+
+MappedFile map_file(const char *file_name);
+void unmap_file(MappedFile *mapped_file);
 
 #endif /* UTILS_H */
@@ -5,8 +5,17 @@
 
 #include "platform.c"
 #include "opengl_win32.c"
+#include "work_queue_win32.c"
+
+// Back the permanent arena with large pages to cut TLB misses walking mesh data. It's all
+// committed up front and falls back to normal pages without the privilege, see
+// win32_enable_large_pages.
+#define USE_LARGE_PAGES 0
 
 static Platform platform;
+static PlatformWorkQueue work_queue;
+static PlatformWorkQueue background_queue;
+static PlatformWorkQueue stream_queue;
 static HDC device_context;
 
 #define INIT_GAME(name) void name(Platform *platform)
@@ -78,6 +87,58 @@ static void win32_unload_dll(GameCode *game_code)
     game_code->shutdown_game = 0;
 }
 
+// Large pages need the "Lock pages in memory" privilege, which the account has to be granted
+// once and the process still has to switch on.
+static b32 win32_enable_large_pages(void)
+{
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) return false;
+
+    TOKEN_PRIVILEGES privileges = { 0 };
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    b32 enabled = LookupPrivilegeValueA(0, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+        AdjustTokenPrivileges(token, FALSE, &privileges, 0, 0, 0) && GetLastError() == ERROR_SUCCESS;
+
+    CloseHandle(token);
+    return enabled;
+}
+
+// Reserves address space only, unless large pages are asked for and allowed. Those can't be
+// committed a bit at a time so the whole size is committed and locked, *committed says which
+// one happened.
+static void *win32_reserve_memory(usize size, b32 large_pages, b32 *committed)
+{
+    *committed = false;
+
+    usize large_page_size = GetLargePageMinimum();
+    if (large_pages && large_page_size && win32_enable_large_pages()) {
+        usize rounded = (size + large_page_size - 1) & ~(large_page_size - 1);
+        void *memory = VirtualAlloc(0, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (memory) {
+            *committed = true;
+            return memory;
+        }
+    }
+
+    return VirtualAlloc(0, size, MEM_RESERVE, PAGE_READWRITE);
+}
+
+static b32 win32_commit_memory(void *memory, usize size)
+{
+    return VirtualAlloc(memory, size, MEM_COMMIT, PAGE_READWRITE) != 0;
+}
+
+static void *win32_reserve_scratch_memory(usize size)
+{
+    return VirtualAlloc(0, size, MEM_RESERVE, PAGE_READWRITE);
+}
+
+static void win32_release_memory(void *memory, usize size)
+{
+    VirtualFree(memory, 0, MEM_RELEASE);
+}
+
 static Vector2 win32_get_mouse_position(HWND window)
 {
     Vector2 result = { 0 };
@@ -128,8 +189,8 @@ static void win32_timer_end_frame(HWND window)
         wait_start = wait_end;
     }
     f32 ms_f = (f32)(1000.0f * ((f64)elapsed_ticks / platform.ticks_per_second));
-    char title[32];
-    sprintf(title, "Epsilon Engine: %f", ms_f);
+    char title[128];
+    snprintf(title, sizeof(title), "Epsilon Engine: %f %s", ms_f, platform.frame_info);
     SetWindowTextA(window, title);
 }
 
@@ -239,8 +300,12 @@ int main()
     wsprintf(dll_file_path, "%s%s.dll", executable_directory, "epsilon");
     wsprintf(temp_dll_file_path, "%stemp_%s.dll", executable_directory, "epsilon");
 
-    platform.permanent_arena_size = gigabytes(1);
-    platform.permanent_arena = VirtualAlloc(0, platform.permanent_arena_size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    // address space is free, only what the arenas grow into is committed
+    platform.permanent_arena_size = USE_LARGE_PAGES ? gigabytes(1) : gigabytes(16);
+    platform.permanent_arena = win32_reserve_memory(platform.permanent_arena_size, USE_LARGE_PAGES, &platform.permanent_arena_committed);
+    platform.commit_memory = win32_commit_memory;
+    platform.reserve_memory = win32_reserve_scratch_memory;
+    platform.release_memory = win32_release_memory;
 
     WNDCLASSEXA window_class = { 0 };
 
@@ -274,6 +339,15 @@ int main()
     platform.load_opengl_function = win32_load_opengl_function;
     platform.swap_buffers = win32_swap_buffers;
 
+    platform.work_queue = &work_queue;
+    platform.worker_count = win32_init_work_queue(&work_queue, 0, 15);
+    platform.background_queue = &background_queue;
+    platform.background_worker_count = win32_init_work_queue(&background_queue, 1, 1);
+    platform.stream_queue = &stream_queue;
+    platform.stream_worker_count = win32_init_work_queue(&stream_queue, 0, 7);
+    platform.add_work_entry = win32_add_work_entry;
+    platform.complete_all_work = win32_complete_all_work;
+
     init_opengl(device_context);
 
     GameCode game_code = win32_load_dll();
@@ -292,6 +366,9 @@ int main()
         FILETIME dll_write_time = win32_get_last_write_to_dll();
 
         if (CompareFileTime(&dll_write_time, &game_code.last_write_time) != 0) {
+            // queued work points at code in the old dll
+            win32_complete_all_work(&work_queue);
+            win32_complete_all_work(&background_queue);
             win32_unload_dll(&game_code);
             game_code = win32_load_dll();
         }
@@ -301,6 +378,9 @@ int main()
         win32_timer_end_frame(window); // passing window is temp just to dispaly ms_f
     }
 
+    // shutdown gives back the threads' scratch, nothing queued can still be using it
+    win32_complete_all_work(&work_queue);
+    win32_complete_all_work(&background_queue);
     game_code.shutdown_game();
     return 0;
 }
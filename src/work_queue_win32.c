@@ -0,0 +1,98 @@
+typedef struct PlatformWorkQueueEntry {
+    PlatformWorkQueueCallback *callback;
+    void *data;
+} PlatformWorkQueueEntry;
+
+struct PlatformWorkQueue {
+    u32 volatile completion_goal;
+    u32 volatile completion_count;
+
+    u32 volatile next_entry_to_write;
+    u32 volatile next_entry_to_read;
+    HANDLE semaphore;
+
+    PlatformWorkQueueEntry entries[256];
+};
+
+static void win32_add_work_entry(PlatformWorkQueue *queue, PlatformWorkQueueCallback *callback, void *data)
+{
+    u32 new_next_entry_to_write = (queue->next_entry_to_write + 1) % array_count(queue->entries);
+    assert(new_next_entry_to_write != queue->next_entry_to_read);
+
+    PlatformWorkQueueEntry *entry = queue->entries + queue->next_entry_to_write;
+    entry->callback = callback;
+    entry->data = data;
+    queue->completion_goal++;
+
+    // entry has to be visible before the workers can see the new write index
+    _WriteBarrier();
+    queue->next_entry_to_write = new_next_entry_to_write;
+    ReleaseSemaphore(queue->semaphore, 1, 0);
+}
+
+static b32 win32_do_next_work_entry(PlatformWorkQueue *queue)
+{
+    b32 should_sleep = false;
+
+    u32 original_next_entry_to_read = queue->next_entry_to_read;
+    u32 new_next_entry_to_read = (original_next_entry_to_read + 1) % array_count(queue->entries);
+    if (original_next_entry_to_read != queue->next_entry_to_write) {
+        u32 index = InterlockedCompareExchange((LONG volatile *)&queue->next_entry_to_read, new_next_entry_to_read, original_next_entry_to_read);
+        if (index == original_next_entry_to_read) {
+            PlatformWorkQueueEntry entry = queue->entries[index];
+            entry.callback(queue, entry.data);
+            InterlockedIncrement((LONG volatile *)&queue->completion_count);
+        }
+    } else {
+        should_sleep = true;
+    }
+
+    return should_sleep;
+}
+
+static void win32_complete_all_work(PlatformWorkQueue *queue)
+{
+    while (queue->completion_goal != queue->completion_count)
+        win32_do_next_work_entry(queue);
+
+    queue->completion_goal = 0;
+    queue->completion_count = 0;
+}
+
+static DWORD WINAPI win32_worker_thread(LPVOID parameter)
+{
+    PlatformWorkQueue *queue = (PlatformWorkQueue *)parameter;
+
+    for (;;) {
+        if (win32_do_next_work_entry(queue))
+            WaitForSingleObjectEx(queue->semaphore, INFINITE, FALSE);
+    }
+}
+
+// Queues the main thread waits on can do without threads, complete_all_work runs their
+// entries. Queues nothing waits on need min_thread_count even if they share a core.
+static u32 win32_init_work_queue(PlatformWorkQueue *queue, u32 min_thread_count, u32 max_thread_count)
+{
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+
+    // leave a core for the main thread, it helps out in complete_all_work
+    u32 thread_count = (system_info.dwNumberOfProcessors > 1) ? system_info.dwNumberOfProcessors - 1 : 0;
+    if (thread_count > max_thread_count)
+        thread_count = max_thread_count;
+    if (thread_count < min_thread_count)
+        thread_count = min_thread_count;
+
+    queue->completion_goal = 0;
+    queue->completion_count = 0;
+    queue->next_entry_to_write = 0;
+    queue->next_entry_to_read = 0;
+    queue->semaphore = CreateSemaphoreExA(0, 0, thread_count + 1, 0, 0, SEMAPHORE_ALL_ACCESS);
+
+    for (u32 i = 0; i < thread_count; i++) {
+        HANDLE thread = CreateThread(0, 0, win32_worker_thread, queue, 0, 0);
+        CloseHandle(thread);
+    }
+
+    return thread_count;
+}